@@ -13,25 +13,35 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <ratio>
+#include <sstream>
 
 #include "build/build_config.h"
 #include "cxxopts.hpp"
 #include "rapidjson/document.h"
 #include "rapidjson/filewritestream.h"
 #include "rapidjson/istreamwrapper.h"
+#include "rapidjson/ostreamwrapper.h"
+#include "rapidjson/prettywriter.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
 
 #include "Assert.h"
 #include "ContextFactory.h"
 #include "FishModel.h"
+#include "FishSimulation.h"
+#include "FrameTimeRecorder.h"
+#include "JobSystem.h"
 #include "Matrix.h"
+#include "MeshCache.h"
 #include "Program.h"
 #include "SeaweedModel.h"
 #include "Texture.h"
+#include "Trace.h"
 #include "opengl/ContextGL.h"
 
 #if defined(OS_WIN)
@@ -58,6 +68,55 @@ static std::chrono::steady_clock::time_point getCurrentTimePoint() {
 #endif
 }
 
+constexpr int Aquarium::kFindMaxFishLimit;
+
+static UPLOADSTRATEGY getUploadStrategyByName(const std::string &name) {
+  for (int strategy = 0; strategy < UPLOADSTRATEGY::UPLOADMAX; ++strategy) {
+    if (name == g_uploadStrategyNames[strategy]) {
+      return static_cast<UPLOADSTRATEGY>(strategy);
+    }
+  }
+  return UPLOADSTRATEGY::UPLOADMAX;
+}
+
+// Parse the length of a benchmark phase, which is a frame count, or seconds
+// followed by 's'.
+static bool parseBenchmarkPhase(const std::string &text,
+                                BenchmarkPhase *phase) {
+  const char *begin = text.c_str();
+  char *end;
+  double value = std::strtod(begin, &end);
+  if (end == begin || value < 0) {
+    return false;
+  }
+
+  if (std::string(end) == "s") {
+    phase->frames = 0;
+    phase->time =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(value));
+    return true;
+  }
+  if (*end != '\0' || value != std::floor(value) || value > INT_MAX) {
+    return false;
+  }
+  phase->frames = static_cast<int>(value);
+  phase->time = std::chrono::steady_clock::duration::zero();
+  return true;
+}
+
+// Quote a field of csv, doubling quotes in it.
+static std::string quoteCsvField(const std::string &field) {
+  std::string quoted = "\"";
+  for (char c : field) {
+    if (c == '"') {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
 Aquarium::Aquarium()
     : mModelEnumMap(),
       mTextureMap(),
@@ -68,7 +127,14 @@ Aquarium::Aquarium()
       mCurFishCount(500),
       mPreFishCount(0),
       mTestTime(INT_MAX),
-      mFactory(nullptr) {
+      mFactory(nullptr),
+      mFishSimulation(new FishSimulation()),
+      mJobSystem(nullptr),
+      mBenchmark(false),
+      mBenchmarkWarmup(),
+      mBenchmarkMeasure(),
+      mFindMaxFishFps(0.0),
+      mCheckFishSimulation(false) {
   g.then = getCurrentTimePoint();
   g.mclock = 0.0;
   g.eyeClock = 0.0;
@@ -102,6 +168,9 @@ Aquarium::Aquarium()
 }
 
 Aquarium::~Aquarium() {
+  // Workers are idle by now, so every event is in the trace.
+  Tracer::stop();
+
   for (auto &tex : mTextureMap) {
     if (tex.second != nullptr) {
       delete tex.second;
@@ -129,6 +198,8 @@ Aquarium::~Aquarium() {
   }
 
   delete mFactory;
+  delete mFishSimulation;
+  delete mJobSystem;
 }
 
 BACKENDTYPE Aquarium::getBackendType(const std::string &backendPath) {
@@ -154,6 +225,8 @@ BACKENDTYPE Aquarium::getBackendType(const std::string &backendPath) {
 #endif
   } else if (backendPath == "opengl") {
     return BACKENDTYPE::BACKENDTYPEOPENGL;
+  } else if (backendPath == "null") {
+    return BACKENDTYPE::BACKENDTYPENULL;
   }
   return BACKENDTYPENONE;
 }
@@ -165,24 +238,55 @@ bool Aquarium::init(int argc, char **argv) {
   cxxopts::Options options(argv[0],
                            "A native implementation of WebGL Aquarium");
   cxxopts::OptionAdder oa = options.allow_unrecognised_options().add_options();
-  oa("backend", "Set a backend, like 'dawn_d3d12' or 'd3d12'",
+  oa("backend",
+     "Set a backend, like 'dawn_d3d12' or 'd3d12'. 'null' does the cpu work "
+     "without rendering",
      cxxopts::value<std::string>());
   oa("alpha-blending", "Format is <0-1|false>. Set alpha blending",
      cxxopts::value<std::string>());
+  oa("benchmark",
+     "Format is <warmup,measure>. Render warmup frames, then record the time "
+     "of each frame in measure and print statistics of them, then exit. Each "
+     "of them is a frame count, or seconds followed by 's', like 5s,20s",
+     cxxopts::value<std::string>());
+  oa("benchmark-output",
+     "Format is <path>. Write benchmark results to a .csv or .json file "
+     "instead of printing them as json",
+     cxxopts::value<std::string>());
   oa("buffer-mapping-async",
      "Upload uniforms by buffer mapping async for Dawn backend");
+  oa("check-fish-simulation",
+     "Compare each fish simulation instruction set supported by the cpu with "
+     "the scalar reference on 200003 fishes of each type, print the largest "
+     "differences and exit. No backend is needed");
   oa("disable-control-panel", "Turn off control panel");
   oa("disable-d3d12-render-pass",
      "Turn off render pass for dawn_d3d12 and d3d12 backend");
   oa("disable-dawn-validation", "Turn off dawn validation");
   oa("disable-dynamic-buffer-offset",
-     "Create many binding groups for a single draw. Dawn only");
+     "Rebind the fish vertex buffer for each fish draw. Dawn only");
   oa("discrete-gpu",
      "Choose discrete gpu to render the application. Dawn and D3D12 only.");
   oa("integrated-gpu",
      "Choose integrated gpu to render the application. Dawn and D3D12 only.");
   oa("enable-full-screen-mode",
      "Render aquarium in full screen mode instead of window mode");
+  oa("find-max-fish",
+     "Format is <fps>. Search the highest fish count rendered at the fps, "
+     "print the frame time of each count tried and exit. Each count is "
+     "rendered for 2s to settle and 5s to measure, or the warmup and measure "
+     "of --benchmark if it's designated",
+     cxxopts::value<double>());
+  oa("fish-simulation-isa",
+     "Format is <scalar|sse4|avx2|avx512>. Set the instruction set of fish "
+     "simulation. The best one supported by the cpu is used by default",
+     cxxopts::value<std::string>());
+  oa("gpu-fish-simulation",
+     "Simulate fishes by a compute shader instead of cpu. Dawn only.");
+  oa("headless",
+     "Render into offscreen textures without a window. It runs without a "
+     "display server, so it needs --test-time, --benchmark, --find-max-fish "
+     "or --upload-benchmark to quit. Dawn, and OpenGL on Linux only.");
   oa("msaa-sample-count", "Set MSAA sample count. 1 for non-MSAA",
      cxxopts::value<int>());
   oa("num-fish", "Set how many fishes will be rendered.",
@@ -193,9 +297,26 @@ bool Aquarium::init(int argc, char **argv) {
      "Load fish behavior from FishBehavior.json. Dawn only.");
   oa("test-time", "Render for some seconds then exit.",
      cxxopts::value<int>(mTestTime));
+  oa("trace-file",
+     "Record init and frame phases to a Chrome trace event json file, which "
+     "opens in chrome://tracing or Perfetto. Needs enable_trace at build "
+     "time.",
+     cxxopts::value<std::string>());
   oa("turn-off-vsync", "Unlimit 60 fps");
+  oa("upload-benchmark",
+     "Format is <count,count,...>. Render each upload strategy with each of "
+     "the fish counts and print the cost of uploads, then exit. Dawn only.",
+     cxxopts::value<std::string>());
+  oa("upload-strategy",
+     "Format is <staging|mapping-async|write-buffer>. Set how per frame data "
+     "is uploaded. Dawn only.",
+     cxxopts::value<std::string>());
   oa("window-size", "Format is <width,height>. Set window size",
      cxxopts::value<std::string>());
+  oa("worker-threads",
+     "Set how many threads update fishes, including the main thread. One "
+     "thread per core by default",
+     cxxopts::value<int>());
   oa("help", "Print help");
   auto result = options.parse(argc, argv);
 
@@ -204,11 +325,28 @@ bool Aquarium::init(int argc, char **argv) {
     return false;
   }
 
+  if (result.count("check-fish-simulation")) {
+    mCheckFishSimulation = true;
+    return true;
+  }
+
+  if (result.count("trace-file")) {
+#if defined(ENABLE_TRACE)
+    Tracer::start(result["trace-file"].as<std::string>());
+#else
+    std::cerr << "Tracing isn't enabled in the build, please build with "
+                 "enable_trace = true."
+              << std::endl;
+    return false;
+#endif
+  }
+
   if (!result.count("backend")) {
     std::cout << "Option --backend needs to be designated" << std::endl;
     return false;
   }
   std::string backend = result["backend"].as<std::string>();
+  mBackendName = backend;
   mBackendType = getBackendType(backend);
   if (mBackendType == BACKENDTYPE::BACKENDTYPENONE) {
     std::cout << "Can not create " << backend << " backend" << std::endl;
@@ -247,6 +385,89 @@ bool Aquarium::init(int argc, char **argv) {
     }
 
     toggleBitset.set(static_cast<size_t>(TOGGLE::BUFFERMAPPINGASYNC));
+    mContext->setUploadStrategy(UPLOADSTRATEGY::UPLOADMAPPINGASYNC);
+  }
+
+  if (result.count("upload-strategy")) {
+    std::string strategyName = result["upload-strategy"].as<std::string>();
+    UPLOADSTRATEGY strategy = getUploadStrategyByName(strategyName);
+    if (!mContext->setUploadStrategy(strategy)) {
+      std::cerr << "Upload strategy " << strategyName
+                << " isn't supported for the backend." << std::endl;
+      return false;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::BUFFERMAPPINGASYNC),
+                     strategy == UPLOADSTRATEGY::UPLOADMAPPINGASYNC);
+  }
+
+  if (result.count("upload-benchmark")) {
+    if (!mContext->setUploadStrategy(UPLOADSTRATEGY::UPLOADSTAGING)) {
+      std::cerr << "Upload benchmark is only implemented for Dawn backend."
+                << std::endl;
+      return false;
+    }
+    std::stringstream fishCounts(result["upload-benchmark"].as<std::string>());
+    std::string fishCount;
+    while (std::getline(fishCounts, fishCount, ',')) {
+      mUploadBenchmarkFishCounts.push_back(std::atoi(fishCount.c_str()));
+      if (mUploadBenchmarkFishCounts.back() <= 0) {
+        std::cerr << "Please designate fish counts of upload benchmark "
+                     "correctly."
+                  << std::endl;
+        return false;
+      }
+    }
+    toggleBitset.reset(static_cast<size_t>(TOGGLE::BUFFERMAPPINGASYNC));
+  }
+
+  if (result.count("benchmark")) {
+    if (!mUploadBenchmarkFishCounts.empty()) {
+      std::cerr << "Benchmark can't be run with upload benchmark." << std::endl;
+      return false;
+    }
+    mBenchmarkPhases = result["benchmark"].as<std::string>();
+    size_t pos = mBenchmarkPhases.find(",");
+    if (pos == std::string::npos ||
+        !parseBenchmarkPhase(mBenchmarkPhases.substr(0, pos),
+                             &mBenchmarkWarmup) ||
+        !parseBenchmarkPhase(mBenchmarkPhases.substr(pos + 1),
+                             &mBenchmarkMeasure) ||
+        (mBenchmarkMeasure.frames == 0 &&
+         mBenchmarkMeasure.time.count() == 0)) {
+      std::cerr << "Please designate warmup and measure of benchmark correctly."
+                << std::endl;
+      return false;
+    }
+    mBenchmark = true;
+  }
+
+  if (result.count("benchmark-output")) {
+    if (!mBenchmark) {
+      std::cerr << "Benchmark output needs --benchmark." << std::endl;
+      return false;
+    }
+    mBenchmarkOutputPath = result["benchmark-output"].as<std::string>();
+  }
+
+  if (result.count("find-max-fish")) {
+    if (!mUploadBenchmarkFishCounts.empty()) {
+      std::cerr << "Max fish count can't be searched with upload benchmark."
+                << std::endl;
+      return false;
+    }
+    mFindMaxFishFps = result["find-max-fish"].as<double>();
+    if (mFindMaxFishFps <= 0.0) {
+      std::cerr << "Please designate the target fps of max fish count search "
+                   "correctly."
+                << std::endl;
+      return false;
+    }
+    if (!mBenchmark) {
+      mBenchmarkWarmup.frames = 0;
+      mBenchmarkWarmup.time = std::chrono::seconds(2);
+      mBenchmarkMeasure.frames = 0;
+      mBenchmarkMeasure.time = std::chrono::seconds(5);
+    }
   }
 
   if (result.count("disable-control-panel")) {
@@ -328,6 +549,33 @@ bool Aquarium::init(int argc, char **argv) {
     toggleBitset.set(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE));
   }
 
+  if (result.count("headless")) {
+    if (!availableToggleBitset.test(static_cast<size_t>(TOGGLE::HEADLESS))) {
+      std::cerr << "Headless mode isn't supported for the backend."
+                << std::endl;
+      return false;
+    }
+    if (toggleBitset.test(
+            static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE))) {
+      std::cerr << "Headless mode can't be used with full screen mode."
+                << std::endl;
+      return false;
+    }
+    // Nothing can close a headless run, so it must have an end.
+    if (!result.count("test-time") && !mBenchmark &&
+        mFindMaxFishFps <= 0.0 && mUploadBenchmarkFishCounts.empty() &&
+        !mCheckFishSimulation) {
+      std::cerr << "Headless mode needs --test-time, --benchmark, "
+                   "--find-max-fish or --upload-benchmark."
+                << std::endl;
+      return false;
+    }
+
+    toggleBitset.set(static_cast<size_t>(TOGGLE::HEADLESS));
+    // There is no window to show the control panel in.
+    toggleBitset.set(static_cast<size_t>(TOGGLE::DISABLECONTROLPANEL));
+  }
+
   if (result.count("enable-instanced-draws")) {
     /*if
     (!availableToggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEINSTANCEDDRAWS)))
@@ -342,6 +590,28 @@ bool Aquarium::init(int argc, char **argv) {
     return false;
   }
 
+  if (result.count("gpu-fish-simulation")) {
+    if (!availableToggleBitset.test(
+            static_cast<size_t>(TOGGLE::GPUFISHSIMULATION))) {
+      std::cerr << "Fish simulation on gpu is only implemented for Dawn "
+                   "backend."
+                << std::endl;
+      return false;
+    }
+
+    toggleBitset.set(static_cast<size_t>(TOGGLE::GPUFISHSIMULATION));
+  }
+
+  if (result.count("fish-simulation-isa")) {
+    std::string isaName = result["fish-simulation-isa"].as<std::string>();
+    if (!mFishSimulation->setSimdIsa(
+            FishSimulation::getSimdIsaByName(isaName))) {
+      std::cerr << "Fish simulation isa " << isaName
+                << " isn't supported by the cpu." << std::endl;
+      return false;
+    }
+  }
+
   if (result.count("msaa-sample-count")) {
     mContext->setMSAASampleCount(result["msaa-sample-count"].as<int>());
   }
@@ -383,9 +653,22 @@ bool Aquarium::init(int argc, char **argv) {
     }
   }
 
-  if (!mContext->initialize(mBackendType, toggleBitset, windowWidth,
-                            windowHeight)) {
-    return false;
+  int workerThreads = JobSystem::getDefaultThreadCount();
+  if (result.count("worker-threads")) {
+    workerThreads = result["worker-threads"].as<int>();
+    if (workerThreads < 1) {
+      std::cerr << "Please designate at least one worker thread." << std::endl;
+      return false;
+    }
+  }
+  mJobSystem = new JobSystem(workerThreads);
+
+  {
+    TRACE_SCOPE("initializeContext");
+    if (!mContext->initialize(mBackendType, toggleBitset, windowWidth,
+                              windowHeight)) {
+      return false;
+    }
   }
 
   calculateFishCount();
@@ -396,16 +679,31 @@ bool Aquarium::init(int argc, char **argv) {
   const ResourceHelper *resourceHelper = mContext->getResourceHelper();
   std::vector<std::string> skyUrls;
   resourceHelper->getSkyBoxUrls(&skyUrls);
-  mTextureMap["skybox"] = mContext->createTexture("skybox", skyUrls);
+  Texture *skybox = mContext->createTexture("skybox", skyUrls);
+  if (resourceHelper->createCacheFolder()) {
+    skybox->setCachePath(resourceHelper->getTextureCachePath("skybox"));
+  }
+  {
+    TRACE_SCOPE("loadSkybox");
+    skybox->loadTexture();
+  }
+  mTextureMap["skybox"] = skybox;
 
-  // Init general buffer and binding groups for dawn backend.
-  mContext->initGeneralResources(this);
+  // Init general buffer and binding groups for dawn and OpenGL backends.
+  {
+    TRACE_SCOPE("initGeneralResources");
+    mContext->initGeneralResources(this);
+    mContext->updateFishParams(this);
+  }
   // Avoid resource allocation in the first render loop
   mPreFishCount = mCurFishCount;
 
   setupModelEnumMap();
-  loadReource();
-  mContext->Flush();
+  {
+    TRACE_SCOPE("loadResources");
+    loadReource();
+    mContext->Flush();
+  }
 
   std::cout << "End loading.\nCost "
             << std::chrono::duration<double>(getElapsedTime()).count()
@@ -422,18 +720,30 @@ void Aquarium::resetFpsTime() {
   g.then = g.start;
 }
 
-void Aquarium::display() {
-  while (!mContext->ShouldQuit()) {
-    mContext->KeyBoardQuit();
-    render();
+bool Aquarium::display() {
+  if (mCheckFishSimulation) {
+    return checkFishSimulation();
+  }
 
-    mContext->DoFlush(toggleBitset);
+  if (!mUploadBenchmarkFishCounts.empty()) {
+    runUploadBenchmark();
+  } else if (mFindMaxFishFps > 0.0) {
+    runFindMaxFish();
+  } else if (mBenchmark) {
+    runBenchmark();
+  } else {
+    while (!mContext->ShouldQuit()) {
+      mContext->KeyBoardQuit();
+      render();
 
-    auto totalTime = std::chrono::duration_cast<
-        std::chrono::duration<std::chrono::steady_clock::duration::rep>>(
-        g.then - g.start);
-    if ((totalTime.count() & INT_MAX) > mTestTime) {
-      break;
+      mContext->DoFlush(toggleBitset);
+
+      auto totalTime = std::chrono::duration_cast<
+          std::chrono::duration<std::chrono::steady_clock::duration::rep>>(
+          g.then - g.start);
+      if ((totalTime.count() & INT_MAX) > mTestTime) {
+        break;
+      }
     }
   }
 
@@ -442,6 +752,343 @@ void Aquarium::display() {
   if (toggleBitset.test(static_cast<size_t>(TOGGLE::PRINTLOG))) {
     printAvgFps();
   }
+
+  return true;
+}
+
+// Render frameCount frames. Return false if the window is closed.
+bool Aquarium::renderFrames(int frameCount) {
+  for (int frame = 0; frame < frameCount; ++frame) {
+    if (mContext->ShouldQuit()) {
+      return false;
+    }
+    mContext->KeyBoardQuit();
+    render();
+    mContext->DoFlush(toggleBitset);
+  }
+  return true;
+}
+
+// Render each upload strategy with each fish count. The first frames after a
+// switch aren't measured, so that staging buffers have grown to fit a frame.
+// Frame time is the wall time of the main thread per frame, and upload time is
+// the part of it spent in uploading and submitting per frame data, including
+// stalls on staging memory that is still in use by the gpu.
+void Aquarium::runUploadBenchmark() {
+  std::cout << "strategy,fish,frame ms,upload ms,stall ms,uploaded KB"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(3);
+  for (int strategy = 0; strategy < UPLOADSTRATEGY::UPLOADMAX; ++strategy) {
+    if (!mContext->setUploadStrategy(static_cast<UPLOADSTRATEGY>(strategy))) {
+      continue;
+    }
+    toggleBitset.set(static_cast<size_t>(TOGGLE::BUFFERMAPPINGASYNC),
+                     strategy == UPLOADSTRATEGY::UPLOADMAPPINGASYNC);
+
+    for (int fishCount : mUploadBenchmarkFishCounts) {
+      mCurFishCount = fishCount;
+      if (!renderFrames(kUploadBenchmarkWarmupFrames)) {
+        return;
+      }
+
+      mContext->resetUploadStats();
+      std::chrono::steady_clock::time_point begin = getCurrentTimePoint();
+      if (!renderFrames(kUploadBenchmarkFrames)) {
+        return;
+      }
+      std::chrono::duration<double, std::milli> frameTime =
+          getCurrentTimePoint() - begin;
+      UploadStats stats = mContext->getUploadStats();
+      std::chrono::duration<double, std::milli> uploadTime = stats.uploadTime;
+      std::chrono::duration<double, std::milli> stallTime = stats.stallTime;
+
+      std::cout << g_uploadStrategyNames[strategy] << "," << fishCount << ","
+                << frameTime.count() / kUploadBenchmarkFrames << ","
+                << uploadTime.count() / kUploadBenchmarkFrames << ","
+                << stallTime.count() / kUploadBenchmarkFrames << ","
+                << stats.uploadedBytes / 1024.0 / kUploadBenchmarkFrames
+                << std::endl;
+    }
+  }
+}
+
+bool Aquarium::renderBenchmarkPhase(const BenchmarkPhase &phase,
+                                    FrameTimeRecorder *recorder) {
+  std::chrono::steady_clock::time_point begin = getCurrentTimePoint();
+  std::chrono::steady_clock::time_point frameEnd = begin;
+  for (int frame = 0; phase.frames != 0 ? frame < phase.frames
+                                        : frameEnd - begin < phase.time;
+       ++frame) {
+    if (!renderFrames(1)) {
+      return false;
+    }
+
+    std::chrono::steady_clock::time_point now = getCurrentTimePoint();
+    if (recorder != nullptr) {
+      recorder->addFrame(now - frameEnd);
+    }
+    frameEnd = now;
+  }
+  return true;
+}
+
+// Frame time is the wall time between the ends of successive frames, so that
+// it includes waiting for the gpu and presenting.
+void Aquarium::runBenchmark() {
+  FrameTimeRecorder recorder;
+  if (!renderBenchmarkPhase(mBenchmarkWarmup, nullptr) ||
+      !renderBenchmarkPhase(mBenchmarkMeasure, &recorder)) {
+    std::cerr << "Benchmark is interrupted." << std::endl;
+    return;
+  }
+
+  if (mBenchmarkOutputPath.empty()) {
+    writeBenchmarkJson(std::cout, recorder);
+    return;
+  }
+
+  std::ofstream stream(mBenchmarkOutputPath, std::ios::out);
+  if (!stream) {
+    std::cerr << "Failed to open " << mBenchmarkOutputPath << std::endl;
+    return;
+  }
+  const std::string csvExtension = ".csv";
+  if (mBenchmarkOutputPath.size() >= csvExtension.size() &&
+      mBenchmarkOutputPath.compare(
+          mBenchmarkOutputPath.size() - csvExtension.size(),
+          csvExtension.size(), csvExtension) == 0) {
+    writeBenchmarkCsv(stream, recorder);
+  } else {
+    writeBenchmarkJson(stream, recorder);
+  }
+  if (!stream) {
+    std::cerr << "Failed to write " << mBenchmarkOutputPath << std::endl;
+    return;
+  }
+  std::cout << "Benchmark results are written to " << mBenchmarkOutputPath
+            << std::endl;
+}
+
+void Aquarium::writeBenchmarkJson(std::ostream &stream,
+                                  const FrameTimeRecorder &recorder) const {
+  FrameTimeStats stats = recorder.computeStats();
+
+  rapidjson::OStreamWrapper streamWrapper(stream);
+  rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(streamWrapper);
+  writer.StartObject();
+  writer.Key("backend");
+  writer.String(mBackendName.c_str());
+  writer.Key("renderer");
+  writer.String(mContext->getResourceHelper()->getRendererInfo().c_str());
+  writer.Key("fishCount");
+  writer.Int(mCurFishCount);
+  writer.Key("width");
+  writer.Int(mContext->getClientWidth());
+  writer.Key("height");
+  writer.Int(mContext->getclientHeight());
+  writer.Key("fishSimulationIsa");
+  writer.String(FishSimulation::getSimdIsaName(mFishSimulation->getSimdIsa()));
+  writer.Key("workerThreads");
+  writer.Int(mJobSystem->getThreadCount());
+  writer.Key("toggles");
+  writer.StartArray();
+  for (int toggle = 0; toggle < TOGGLE::TOGGLEMAX; ++toggle) {
+    if (toggleBitset.test(static_cast<size_t>(toggle))) {
+      writer.String(g_toggleNames[toggle]);
+    }
+  }
+  writer.EndArray();
+  writer.Key("phases");
+  writer.String(mBenchmarkPhases.c_str());
+
+  writer.Key("frames");
+  writer.Uint64(stats.frameCount);
+  writer.Key("totalMs");
+  writer.Double(stats.totalTime);
+  writer.Key("meanMs");
+  writer.Double(stats.mean);
+  writer.Key("medianMs");
+  writer.Double(stats.median);
+  writer.Key("p90Ms");
+  writer.Double(stats.p90);
+  writer.Key("p99Ms");
+  writer.Double(stats.p99);
+  writer.Key("p999Ms");
+  writer.Double(stats.p999);
+  writer.Key("minMs");
+  writer.Double(stats.min);
+  writer.Key("maxMs");
+  writer.Double(stats.max);
+  writer.Key("stddevMs");
+  writer.Double(stats.stddev);
+  writer.Key("averageFps");
+  writer.Double(stats.averageFps);
+  writer.Key("stutters");
+  writer.Int(stats.stutterCount);
+  writer.Key("stutterThresholdMs");
+  writer.Double(stats.stutterThreshold);
+
+  writer.Key("frameTimesMs");
+  writer.StartArray();
+  for (double frameTime : recorder.getFrameTimes()) {
+    writer.Double(frameTime);
+  }
+  writer.EndArray();
+  writer.EndObject();
+  stream << std::endl;
+}
+
+// A header and a row of statistics, which can be appended to a table of
+// earlier runs. Frame times are only written to json.
+void Aquarium::writeBenchmarkCsv(std::ostream &stream,
+                                 const FrameTimeRecorder &recorder) const {
+  FrameTimeStats stats = recorder.computeStats();
+
+  std::string toggles;
+  for (int toggle = 0; toggle < TOGGLE::TOGGLEMAX; ++toggle) {
+    if (toggleBitset.test(static_cast<size_t>(toggle))) {
+      if (!toggles.empty()) {
+        toggles += " ";
+      }
+      toggles += g_toggleNames[toggle];
+    }
+  }
+
+  stream << "backend,renderer,fish,width,height,fish simulation isa,worker "
+            "threads,toggles,phases,frames,total ms,mean ms,median ms,p90 "
+            "ms,p99 ms,p99.9 ms,min ms,max ms,stddev ms,avg fps,stutters,"
+            "stutter threshold ms"
+         << std::endl;
+  stream << quoteCsvField(mBackendName) << ","
+         << quoteCsvField(mContext->getResourceHelper()->getRendererInfo())
+         << "," << mCurFishCount << "," << mContext->getClientWidth() << ","
+         << mContext->getclientHeight() << ","
+         << FishSimulation::getSimdIsaName(mFishSimulation->getSimdIsa())
+         << "," << mJobSystem->getThreadCount() << ","
+         << quoteCsvField(toggles) << "," << quoteCsvField(mBenchmarkPhases)
+         << "," << stats.frameCount << std::fixed << std::setprecision(3)
+         << "," << stats.totalTime << "," << stats.mean << "," << stats.median
+         << "," << stats.p90 << "," << stats.p99 << "," << stats.p999 << ","
+         << stats.min << "," << stats.max << "," << stats.stddev << ","
+         << stats.averageFps << "," << stats.stutterCount << ","
+         << stats.stutterThreshold << std::endl;
+}
+
+// The fish count doubles until it's not stable, then the range between the
+// highest stable count and the lowest unstable one is bisected until it's
+// narrower than 1% of the stable count. Fish count changes go through
+// reallocResource() as they do at runtime.
+void Aquarium::runFindMaxFish() {
+  std::cout << "fish,frames,mean ms,median ms,p90 ms,p99 ms,max ms,fps,stable"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision(3);
+
+  int stableCount = 0;
+  int unstableCount = 0;
+  int fishCount = kFindMaxFishInitialCount;
+  while (unstableCount == 0 ||
+         unstableCount - stableCount > std::max(stableCount / 100, 1)) {
+    bool stable;
+    if (!measureFishCount(fishCount, &stable)) {
+      std::cerr << "Max fish count search is interrupted." << std::endl;
+      return;
+    }
+
+    if (stable) {
+      stableCount = fishCount;
+    } else {
+      unstableCount = fishCount;
+    }
+
+    if (unstableCount != 0) {
+      fishCount = stableCount + (unstableCount - stableCount) / 2;
+    } else if (fishCount < kFindMaxFishLimit) {
+      fishCount = std::min(fishCount * 2, kFindMaxFishLimit);
+    } else {
+      break;
+    }
+  }
+
+  std::cout << std::defaultfloat;
+  if (stableCount == 0) {
+    std::cout << "No fish count is rendered at " << mFindMaxFishFps << " fps."
+              << std::endl;
+  } else if (unstableCount == 0) {
+    std::cout << "Max fish count at " << mFindMaxFishFps
+              << " fps reaches the search limit " << stableCount << "."
+              << std::endl;
+  } else {
+    std::cout << "Max fish count at " << mFindMaxFishFps
+              << " fps: " << stableCount << std::endl;
+  }
+}
+
+bool Aquarium::measureFishCount(int fishCount, bool *stable) {
+  mCurFishCount = fishCount;
+
+  FrameTimeRecorder recorder;
+  if (!renderBenchmarkPhase(mBenchmarkWarmup, nullptr) ||
+      !renderBenchmarkPhase(mBenchmarkMeasure, &recorder)) {
+    return false;
+  }
+
+  FrameTimeStats stats = recorder.computeStats();
+  double targetFrameTime = 1000.0 / mFindMaxFishFps;
+  *stable = stats.frameCount > 0 &&
+            stats.averageFps >= mFindMaxFishFps * kFindMaxFishFpsTolerance &&
+            stats.p90 <= targetFrameTime * kFindMaxFishP90Tolerance;
+
+  std::cout << fishCount << "," << stats.frameCount << "," << stats.mean << ","
+            << stats.median << "," << stats.p90 << "," << stats.p99 << ","
+            << stats.max << "," << stats.averageFps << ","
+            << (*stable ? "yes" : "no") << std::endl;
+  return true;
+}
+
+// Compare each SIMD kernel with the scalar reference at the start and after an
+// hour of rendering. Fish clocks grow with the fish index, so a large fish
+// count covers the large arguments of sin and cos.
+bool Aquarium::checkFishSimulation() {
+  for (int fishType = 0; fishType < NUM_FISH_TYPES; ++fishType) {
+    fishCount[fishType] = kFishSimulationCheckCount;
+  }
+  generateFishParams();
+
+  const float clocks[] = {0.0f, 3600.0f};
+  bool passed = true;
+  for (int isa = SIMDISA::SIMDSCALAR + 1; isa < SIMDISA::SIMDMAX; ++isa) {
+    const char *isaName =
+        FishSimulation::getSimdIsaName(static_cast<SIMDISA>(isa));
+    if (!FishSimulation::isSimdIsaSupported(static_cast<SIMDISA>(isa))) {
+      std::cout << isaName << ": not supported by the cpu" << std::endl;
+      continue;
+    }
+
+    float maxDifference = 0.0f;
+    for (float clock : clocks) {
+      g.mclock = clock;
+      for (int fishType = 0; fishType < NUM_FISH_TYPES; ++fishType) {
+        FishConstants constants;
+        getFishConstants(fishType, &constants);
+        maxDifference = std::max(
+            maxDifference,
+            mFishSimulation->compareWithScalar(static_cast<SIMDISA>(isa),
+                                               fishType, constants));
+      }
+    }
+
+    bool isaPassed = maxDifference <= kFishSimulationCheckTolerance;
+    std::cout << isaName << ": max difference " << maxDifference << ", "
+              << (isaPassed ? "passed" : "failed") << std::endl;
+    passed = passed && isaPassed;
+  }
+
+  if (!passed) {
+    std::cerr << "Fish simulation differs from the scalar reference by more "
+                 "than "
+              << kFishSimulationCheckTolerance << "." << std::endl;
+  }
+  return passed;
 }
 
 void Aquarium::loadReource() {
@@ -478,26 +1125,74 @@ void Aquarium::loadPlacement() {
     const rapidjson::Value &worldMatrix = objects[i]["worldMatrix"];
     ASSERT(worldMatrix.IsArray() && worldMatrix.Size() == 16);
 
-    std::vector<float> matrix;
+    Mat4 world;
     for (rapidjson::SizeType j = 0; j < worldMatrix.Size(); ++j) {
-      matrix.push_back(worldMatrix[j].GetFloat());
+      world.m[j] = worldMatrix[j].GetFloat();
     }
 
-    MODELNAME modelname = mModelEnumMap[name.GetString()];
-    mAquariumModels[modelname]->worldmatrices.push_back(matrix);
+    float inverse[16];
+    Mat4 inverseTranspose;
+    matrix::inverse4(inverse, world.m);
+    matrix::transpose4(inverseTranspose.m, inverse);
+
+    Model *model = mAquariumModels[mModelEnumMap[name.GetString()]];
+    model->worldmatrices.push_back(world);
+    model->worldInverseTransposes.push_back(inverseTranspose);
+    model->worldViewProjections.resize(model->worldmatrices.size());
   }
 }
 
+// Load models in stages. Meshes and textures are mapped from caches, or parsed
+// and decoded, by the job system. Then this thread creates all of the graphics
+// resources, since backends aren't thread safe.
 void Aquarium::loadModels() {
   bool enableInstanceddraw =
       toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEINSTANCEDDRAWS));
+  std::vector<const G_sceneInfo *> infos;
   for (const auto &info : g_sceneInfo) {
     if ((enableInstanceddraw && info.type == MODELGROUP::FISH) ||
         ((!enableInstanceddraw) &&
          info.type == MODELGROUP::FISHINSTANCEDDRAW)) {
       continue;
     }
-    loadModel(info);
+    infos.push_back(&info);
+  }
+
+  // Meshes stay mapped until buffers are created.
+  std::vector<MeshCache> meshes(infos.size());
+  mJobSystem->parallelFor(static_cast<int>(infos.size()), [&](int index) {
+    loadMesh(*infos[index], &meshes[index]);
+  });
+
+  // Models share textures by image, so each image is loaded once.
+  const ResourceHelper *resourceHelper = mContext->getResourceHelper();
+  std::string imagePath = resourceHelper->getImagePath();
+  bool enableTextureCache = resourceHelper->createCacheFolder();
+  std::vector<Texture *> textures;
+  for (const MeshCache &mesh : meshes) {
+    for (const MeshTexture &texture : mesh.getTextures()) {
+      if (mTextureMap.find(texture.image) == mTextureMap.end()) {
+        Texture *newTexture =
+            mContext->createTexture(texture.name, imagePath + texture.image);
+        if (enableTextureCache) {
+          newTexture->setCachePath(
+              resourceHelper->getTextureCachePath(texture.image));
+        }
+        mTextureMap[texture.image] = newTexture;
+        textures.push_back(newTexture);
+      }
+    }
+  }
+  mJobSystem->parallelFor(static_cast<int>(textures.size()), [&](int index) {
+    textures[index]->prepareTexture();
+  });
+
+  for (Texture *texture : textures) {
+    TRACE_SCOPE("loadTexture");
+    texture->loadTexture();
+  }
+  for (size_t i = 0; i < infos.size(); ++i) {
+    loadModel(*infos[i], meshes[i]);
   }
 }
 
@@ -523,21 +1218,31 @@ void Aquarium::loadFishScenario() {
   }
 }
 
-// Load vertex and index buffers, textures and program for each model.
-void Aquarium::loadModel(const G_sceneInfo &info) {
+// Parse the json model only if the binary cache is missing or stale, and
+// refresh the cache then. It runs on worker threads.
+void Aquarium::loadMesh(const G_sceneInfo &info, MeshCache *mesh) const {
+  TRACE_SCOPE("loadMesh");
   const ResourceHelper *resourceHelper = mContext->getResourceHelper();
-  std::string imagePath = resourceHelper->getImagePath();
-  std::string programPath = resourceHelper->getProgramPath();
   std::string modelPath =
       resourceHelper->getModelPath(std::string(info.namestr));
+  std::string meshCachePath =
+      resourceHelper->getMeshCachePath(std::string(info.namestr));
 
-  std::ifstream ModelStream(modelPath, std::ios::in);
-  rapidjson::IStreamWrapper is(ModelStream);
-  rapidjson::Document document;
-  document.ParseStream(is);
-  ASSERT(document.IsObject());
-  const rapidjson::Value &models = document["models"];
-  ASSERT(models.IsArray());
+  if (!mesh->load(meshCachePath, modelPath) && mesh->loadJson(modelPath)) {
+    if (resourceHelper->createCacheFolder() &&
+        !mesh->write(meshCachePath, modelPath)) {
+      std::cerr << "Failed to write mesh cache " << meshCachePath
+                << std::endl;
+    }
+  }
+}
+
+// Create vertex and index buffers and program for each model, and bind the
+// textures which are loaded already.
+void Aquarium::loadModel(const G_sceneInfo &info, const MeshCache &mesh) {
+  TRACE_SCOPE("loadModel");
+  const ResourceHelper *resourceHelper = mContext->getResourceHelper();
+  std::string programPath = resourceHelper->getProgramPath();
 
   Model *model;
   if (toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEALPHABLENDING)) &&
@@ -548,45 +1253,27 @@ void Aquarium::loadModel(const G_sceneInfo &info) {
   }
   mAquariumModels[info.name] = model;
 
-  auto &value = models.GetArray()[models.GetArray().Size() - 1];
   {
     // set up textures
-    const rapidjson::Value &textures = value["textures"];
-    for (rapidjson::Value::ConstMemberIterator itr = textures.MemberBegin();
-         itr != textures.MemberEnd(); ++itr) {
-      std::string name = itr->name.GetString();
-      std::string image = itr->value.GetString();
-
-      if (mTextureMap.find(image) == mTextureMap.end()) {
-        mTextureMap[image] = mContext->createTexture(name, imagePath + image);
-      }
-
-      model->textureMap[name] = mTextureMap[image];
+    for (const MeshTexture &texture : mesh.getTextures()) {
+      model->textureMap[texture.name] = mTextureMap[texture.image];
     }
 
     // set up vertices
-    const rapidjson::Value &arrays = value["fields"];
-    for (rapidjson::Value::ConstMemberIterator itr = arrays.MemberBegin();
-         itr != arrays.MemberEnd(); ++itr) {
-      std::string name = itr->name.GetString();
-      int numComponents = itr->value["numComponents"].GetInt();
-      std::string type = itr->value["type"].GetString();
+    for (const MeshField &field : mesh.getFields()) {
       Buffer *buffer;
-      if (name == "indices") {
-        std::vector<unsigned short> vec;
-        for (auto &data : itr->value["data"].GetArray()) {
-          vec.push_back(data.GetInt());
-        }
-        buffer = mContext->createBuffer(numComponents, &vec, true);
+      if (field.isIndex) {
+        buffer = mContext->createBuffer(
+            field.numComponents,
+            static_cast<const unsigned short *>(field.data),
+            field.totalComponents, true);
       } else {
-        std::vector<float> vec;
-        for (auto &data : itr->value["data"].GetArray()) {
-          vec.push_back(data.GetFloat());
-        }
-        buffer = mContext->createBuffer(numComponents, &vec, false);
+        buffer = mContext->createBuffer(field.numComponents,
+                                        static_cast<const float *>(field.data),
+                                        field.totalComponents, false);
       }
 
-      model->bufferMap[name] = buffer;
+      model->bufferMap[field.name] = buffer;
     }
 
     // setup program
@@ -620,6 +1307,7 @@ void Aquarium::loadModel(const G_sceneInfo &info) {
       program = mProgramMap[vsId + fsId];
     } else {
       program = mContext->createProgram(programPath + vsId, programPath + fsId);
+      TRACE_SCOPE("compileProgram");
       if (toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEALPHABLENDING)) &&
           info.type != MODELGROUP::INNER && info.type != MODELGROUP::OUTSIDE) {
         program->compileProgram(true, g.alpha);
@@ -659,6 +1347,57 @@ void Aquarium::calculateFishCount() {
       fishCount[fishInfo.modelName - MODELNAME::MODELSMALLFISHA] = numfloat;
     }
   }
+
+  generateFishParams();
+}
+
+// Generate random parameters of each fish once the population changes. The
+// pseudo random sequence restarts from the same seed and is drawn in the same
+// order as it used to be drawn every frame, so fishes move the same way.
+void Aquarium::generateFishParams() {
+  matrix::resetPseudoRandom();
+
+  for (int fishType = 0; fishType < NUM_FISH_TYPES; ++fishType) {
+    const Fish &fishInfo = fishTable[fishType];
+    int numFish = fishCount[fishType];
+    float fishRadius = fishInfo.radius;
+    float fishRadiusRange = fishInfo.radiusRange;
+    float fishSpeed = fishInfo.speed;
+    float fishSpeedRange = fishInfo.speedRange;
+    float fishHeightRange = g_fishHeightRange * fishInfo.heightRange;
+
+    mFishSimulation->resize(fishType, numFish);
+    float *speeds = mFishSimulation->getSpeed(fishType);
+    float *scales = mFishSimulation->getScale(fishType);
+    float *xRadiuses = mFishSimulation->getXRadius(fishType);
+    float *yRadiuses = mFishSimulation->getYRadius(fishType);
+    float *zRadiuses = mFishSimulation->getZRadius(fishType);
+    for (int ii = 0; ii < numFish; ++ii) {
+      speeds[ii] = fishSpeed +
+                   static_cast<float>(matrix::pseudoRandom()) * fishSpeedRange;
+      scales[ii] = 1.0f + static_cast<float>(matrix::pseudoRandom()) * 1;
+      xRadiuses[ii] = fishRadius + static_cast<float>(matrix::pseudoRandom()) *
+                                       fishRadiusRange;
+      yRadiuses[ii] =
+          2.0f + static_cast<float>(matrix::pseudoRandom()) * fishHeightRange;
+      zRadiuses[ii] = fishRadius + static_cast<float>(matrix::pseudoRandom()) *
+                                       fishRadiusRange;
+    }
+  }
+}
+
+void Aquarium::getFishConstants(int fishType,
+                                FishConstants *constants) const {
+  const Fish &fishInfo = fishTable[fishType];
+  constants->fishBaseClock = g.mclock * g_fishSpeed;
+  constants->fishOffset = g_fishOffset;
+  constants->fishHeight = g_fishHeight + fishInfo.heightOffset;
+  constants->fishXClock = g_fishXClock;
+  constants->fishYClock = g_fishYClock;
+  constants->fishZClock = g_fishZClock;
+  constants->fishTailSpeed = fishInfo.tailSpeed * g_fishTailSpeed;
+  constants->clock = g.mclock;
+  constants->tailOffsetMult = g_tailOffsetMult;
 }
 
 std::chrono::steady_clock::duration Aquarium::getElapsedTime() {
@@ -680,6 +1419,7 @@ void Aquarium::printAvgFps() {
 }
 
 void Aquarium::updateGlobalUniforms() {
+  TRACE_SCOPE("updateGlobalUniforms");
   std::chrono::steady_clock::duration elapsedTime = getElapsedTime();
   std::chrono::steady_clock::duration renderingTime = g.then - g.start;
   std::chrono::steady_clock::duration testTime =
@@ -739,14 +1479,16 @@ void Aquarium::updateGlobalUniforms() {
   matrix::addVector(lightWorldPositionUniform.lightWorldPos,
                     lightWorldPositionUniform.lightWorldPos, g.v3t1, 3);
 
-  // update world uniforms for dawn backend
+  // update world uniforms for dawn and OpenGL backends
   mContext->updateWorldlUniforms(this);
 }
 
 void Aquarium::render() {
-  matrix::resetPseudoRandom();
-
-  mContext->preFrame();
+  TRACE_SCOPE("render");
+  {
+    TRACE_SCOPE("preFrame");
+    mContext->preFrame();
+  }
 
   // Global Uniforms should update after command reallocation.
   updateGlobalUniforms();
@@ -775,11 +1517,13 @@ void Aquarium::render() {
   // "--backend dawn_xxx --disable-dyanmic-buffer-offset"
   if (!toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEINSTANCEDDRAWS)))
     if (mCurFishCount != mPreFishCount) {
+      TRACE_SCOPE("reallocResource");
       calculateFishCount();
       bool enableDynamicBufferOffset = toggleBitset.test(
           static_cast<size_t>(TOGGLE::ENABLEDYNAMICBUFFEROFFSET));
       mContext->reallocResource(mPreFishCount, mCurFishCount,
                                 enableDynamicBufferOffset);
+      mContext->updateFishParams(this);
       mPreFishCount = mCurFishCount;
 
       resetFpsTime();
@@ -800,70 +1544,88 @@ void Aquarium::updateAndDraw() {
           ? MODELNAME::MODELBIGFISHBINSTANCEDDRAWS
           : MODELNAME::MODELBIGFISHB;
 
-  for (int i = MODELRUINCOLUMN; i <= MODELSEAWEEDB; ++i) {
-    Model *model = mAquariumModels[i];
-    model->prepareForDraw();
+  {
+    TRACE_SCOPE("updateBackground");
+    for (int i = MODELRUINCOLUMN; i <= MODELSEAWEEDB; ++i) {
+      Model *model = mAquariumModels[i];
+      model->prepareForDraw();
+
+      size_t instanceCount = model->worldmatrices.size();
+      if (instanceCount > 0) {
+        matrix::mulMatrixMatrix4Batch(model->worldViewProjections[0].m,
+                                      model->worldmatrices[0].m,
+                                      lightWorldPositionUniform.viewProjection,
+                                      instanceCount);
+      }
 
-    for (auto &world : model->worldmatrices) {
-      ASSERT(world.size() == 16);
-      memcpy(worldUniforms.world, world.data(), 16 * sizeof(float));
-      matrix::mulMatrixMatrix4(worldUniforms.worldViewProjection,
-                               worldUniforms.world,
-                               lightWorldPositionUniform.viewProjection);
-      matrix::inverse4(g.worldInverse, worldUniforms.world);
-      matrix::transpose4(worldUniforms.worldInverseTranspose, g.worldInverse);
+      if (drawPerModel) {
+        model->updateInstanceUniforms(
+            model->worldmatrices.data(), model->worldInverseTransposes.data(),
+            model->worldViewProjections.data(), instanceCount);
+        continue;
+      }
 
-      model->updatePerInstanceUniforms(worldUniforms);
-      if (!drawPerModel) {
+      for (size_t w = 0; w < instanceCount; ++w) {
+        copyWorldUniforms(model->worldmatrices[w],
+                          model->worldInverseTransposes[w],
+                          model->worldViewProjections[w], &worldUniforms);
+
+        model->updatePerInstanceUniforms(worldUniforms);
         model->draw();
       }
     }
   }
 
+  FishConstants constants[NUM_FISH_TYPES];
+  FishPer *fishPers[NUM_FISH_TYPES];
   for (int i = fishBegin; i <= fishEnd; ++i) {
     FishModel *model = static_cast<FishModel *>(mAquariumModels[i]);
-    model->prepareForDraw();
+    model->updateInstanceRange();
 
-    const Fish &fishInfo = fishTable[i - fishBegin];
-    int numFish = fishCount[i - fishBegin];
-    float fishBaseClock = g.mclock * g_fishSpeed;
-    float fishRadius = fishInfo.radius;
-    float fishRadiusRange = fishInfo.radiusRange;
-    float fishSpeed = fishInfo.speed;
-    float fishSpeedRange = fishInfo.speedRange;
-    float fishTailSpeed = fishInfo.tailSpeed * g_fishTailSpeed;
-    float fishOffset = g_fishOffset;
-    // float fishClockSpeed  = g_fishSpeed;
-    float fishHeight = g_fishHeight + fishInfo.heightOffset;
-    float fishHeightRange = g_fishHeightRange * fishInfo.heightRange;
-    float fishXClock = g_fishXClock;
-    float fishYClock = g_fishYClock;
-    float fishZClock = g_fishZClock;
+    int fishType = i - fishBegin;
+    getFishConstants(fishType, &constants[fishType]);
 
-    for (int ii = 0; ii < numFish; ++ii) {
-      float fishClock = fishBaseClock + ii * fishOffset;
-      float speed = fishSpeed +
-                    static_cast<float>(matrix::pseudoRandom()) * fishSpeedRange;
-      float scale = 1.0f + static_cast<float>(matrix::pseudoRandom()) * 1;
-      float xRadius = fishRadius + static_cast<float>(matrix::pseudoRandom()) *
-                                       fishRadiusRange;
-      float yRadius =
-          2.0f + static_cast<float>(matrix::pseudoRandom()) * fishHeightRange;
-      float zRadius = fishRadius + static_cast<float>(matrix::pseudoRandom()) *
-                                       fishRadiusRange;
-      float fishSpeedClock = fishClock * speed;
-      float xClock = fishSpeedClock * fishXClock;
-      float yClock = fishSpeedClock * fishYClock;
-      float zClock = fishSpeedClock * fishZClock;
+    // Simulate into the FishPer array of the backend if there is one,
+    // otherwise pass results to the model fish by fish.
+    fishPers[fishType] = model->getFishPers();
+    if (fishPers[fishType] == nullptr) {
+      fishPers[fishType] = mFishSimulation->getScratchFishPers(fishType);
+    }
+  }
+
+  // Fishes are simulated by the backend in gpu fish simulation mode.
+  if (!toggleBitset.test(static_cast<size_t>(TOGGLE::GPUFISHSIMULATION))) {
+    TRACE_SCOPE("simulateFishes");
+    mFishSimulation->updateAll(constants, fishPers, mJobSystem);
+  }
 
+  for (int i = fishBegin; i <= fishEnd; ++i) {
+    TRACE_SCOPE("updateFishes");
+    FishModel *model = static_cast<FishModel *>(mAquariumModels[i]);
+    int fishType = i - fishBegin;
+    bool updateByUniforms = model->getFishPers() == nullptr;
+    if (!updateByUniforms && drawPerModel) {
+      continue;
+    }
+
+    if (!drawPerModel) {
+      model->prepareForDraw();
+    }
+
+    // The model draws all of its fishes from its FishPer array at once.
+    if (!updateByUniforms) {
+      model->updatePerInstanceUniforms(worldUniforms);
+      model->draw();
+      continue;
+    }
+
+    for (int ii = 0; ii < fishCount[fishType]; ++ii) {
+      const FishPer &fishPer = fishPers[fishType][ii];
       model->updateFishPerUniforms(
-          sin(xClock) * xRadius, sin(yClock) * yRadius + fishHeight,
-          cos(zClock) * zRadius, sin(xClock - 0.04f) * xRadius,
-          sin(yClock - 0.01f) * yRadius + fishHeight,
-          cos(zClock - 0.04f) * zRadius, scale,
-          fmod((g.mclock + ii * g_tailOffsetMult) * fishTailSpeed * speed,
-               static_cast<float>(M_PI) * 2),
-          ii);
+          fishPer.worldPosition[0], fishPer.worldPosition[1],
+          fishPer.worldPosition[2], fishPer.nextPosition[0],
+          fishPer.nextPosition[1], fishPer.nextPosition[2], fishPer.scale,
+          fishPer.time, ii);
 
       if (!drawPerModel) {
         model->updatePerInstanceUniforms(worldUniforms);
@@ -875,12 +1637,17 @@ void Aquarium::updateAndDraw() {
   mContext->updateFPS(mFpsTimer, &mCurFishCount, &toggleBitset);
 
   if (drawPerModel) {
-    mContext->updateAllFishData();
-    mContext->beginRenderPass();
-    for (int i = 0; i <= MODELNAME::MODELMAX; ++i) {
-      if (i >= MODELNAME::MODELSMALLFISHA && (i < fishBegin || i > fishEnd))
-        continue;
+    {
+      TRACE_SCOPE("updateAllFishData");
+      mContext->updateAllFishData();
+    }
 
+    TRACE_SCOPE("encodeCommands");
+    mContext->beginRenderPass();
+    mContext->drawBackground(
+        &mAquariumModels[MODELNAME::MODELRUINCOLUMN],
+        MODELNAME::MODELSEAWEEDB - MODELNAME::MODELRUINCOLUMN + 1);
+    for (int i = fishBegin; i <= fishEnd; ++i) {
       Model *model = mAquariumModels[i];
       model->draw();
     }
@@ -11,9 +11,12 @@
 
 #include <bitset>
 #include <chrono>
+#include <cstdint>
+#include <iosfwd>
 #include <queue>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "build/build_config.h"
 
@@ -22,9 +25,14 @@
 
 class Context;
 class ContextFactory;
+class FishSimulation;
+class FrameTimeRecorder;
+class JobSystem;
+class MeshCache;
 class Model;
 class Program;
 class Texture;
+struct FishConstants;
 
 #if defined(OS_WIN)
 #define M_PI 3.141592653589793
@@ -45,8 +53,11 @@ enum BACKENDTYPE {
   BACKENDTYPEOPENGL = 1 << 5,
   BACKENDTYPEVULKAN = 1 << 6,
 
+  // Cpu only backend without graphics API
+  BACKENDTYPENULL = 1 << 7,
+
   // Keep this as last one
-  BACKENDTYPENONE = 1 << 7,
+  BACKENDTYPENONE = 1 << 8,
 };
 
 inline BACKENDTYPE operator|(BACKENDTYPE a, BACKENDTYPE b) {
@@ -144,9 +155,67 @@ enum TOGGLE : short {
   SIMULATINGFISHCOMEANDGO,
   // Turn off vsync, donot limit fps to 60
   TURNOFFVSYNC,
+  // Simulate fishes by a compute pass for Dawn backend
+  GPUFISHSIMULATION,
+  // Render offscreen without a window or display server
+  HEADLESS,
   TOGGLEMAX
 };
 
+// Names of toggles in benchmark results, indexed by TOGGLE.
+const char *const g_toggleNames[] = {"alpha-blending",
+                                     "instanced-draws",
+                                     "dynamic-buffer-offset",
+                                     "disable-d3d12-render-pass",
+                                     "disable-dawn-validation",
+                                     "disable-control-panel",
+                                     "integrated-gpu",
+                                     "discrete-gpu",
+                                     "draw-per-model",
+                                     "full-screen-mode",
+                                     "print-log",
+                                     "buffer-mapping-async",
+                                     "simulating-fish-come-and-go",
+                                     "turn-off-vsync",
+                                     "gpu-fish-simulation",
+                                     "headless"};
+static_assert(sizeof(g_toggleNames) / sizeof(g_toggleNames[0]) ==
+                  TOGGLE::TOGGLEMAX,
+              "Every toggle needs a name");
+
+// How per frame data like uniforms and fish positions is uploaded to the gpu.
+// Only Dawn backend implements them.
+enum UPLOADSTRATEGY : short {
+  // Stage uploads of a frame in a ring of per frame mapped buffers. WebGPU
+  // can't keep a buffer mapped while the queue uses it, so this ring stands
+  // in for persistently mapped upload buffers.
+  UPLOADSTAGING,
+  // Stage uploads in a pool of buffers which are remapped asynchronously
+  UPLOADMAPPINGASYNC,
+  // Let the queue copy the data by queue.WriteBuffer
+  UPLOADWRITEBUFFER,
+  UPLOADMAX
+};
+
+const char *const g_uploadStrategyNames[] = {"staging", "mapping-async",
+                                             "write-buffer"};
+
+// Cost of uploads accumulated since the last reset.
+struct UploadStats {
+  uint64_t uploadedBytes;
+  // Cpu time spent in uploading and submitting the data, including stalls.
+  std::chrono::steady_clock::duration uploadTime;
+  // Time spent waiting for the gpu to release staging memory.
+  std::chrono::steady_clock::duration stallTime;
+};
+
+// Length of a phase of the benchmark. It's frames long if frames isn't 0,
+// otherwise it lasts for time.
+struct BenchmarkPhase {
+  int frames;
+  std::chrono::steady_clock::duration time;
+};
+
 const G_sceneInfo g_sceneInfo[] = {
     {"SmallFishA",
      MODELNAME::MODELSMALLFISHA,
@@ -425,7 +494,6 @@ constexpr float g_fieldOfView = 82.699f;
 struct Global {
   float projection[16];
   float view[16];
-  float worldInverse[16];
   float viewProjectionInverse[16];
   float skyView[16];
   float skyViewProjection[16];
@@ -474,24 +542,44 @@ struct FogUniforms {
   float fogColor[4];
 };
 
+// Per fish data. It's tightly packed, backends upload an array of it and fish
+// shaders read it as per instance vertex data.
 struct FishPer {
   float worldPosition[3];
   float scale;
   float nextPosition[3];
   float time;
-  float padding[56];  // TODO(yizhou): the padding is to align with 256 byte
-                      // offset.
 };
 
 class Aquarium {
 public:
+  // Frames rendered by the upload benchmark after each switch of strategy or
+  // fish count, before and while measuring.
+  static constexpr int kUploadBenchmarkWarmupFrames = 60;
+  static constexpr int kUploadBenchmarkFrames = 300;
+  // The search of the max fish count starts from kFindMaxFishInitialCount and
+  // doesn't go beyond kFindMaxFishLimit. A fish count is stable if the
+  // average fps is at least kFindMaxFishFpsTolerance of the target, and p90
+  // frame time is at most kFindMaxFishP90Tolerance of the target frame time.
+  static constexpr int kFindMaxFishInitialCount = 1000;
+  static constexpr int kFindMaxFishLimit = 2000000;
+  static constexpr double kFindMaxFishFpsTolerance = 0.95;
+  static constexpr double kFindMaxFishP90Tolerance = 1.25;
+  // The fish simulation check updates this many fishes of each type, whose
+  // clocks grow with the index, and allows kFishSimulationCheckTolerance of
+  // difference from the scalar reference.
+  static constexpr int kFishSimulationCheckCount = 200003;
+  static constexpr float kFishSimulationCheckTolerance = 1e-4f;
+
   Aquarium();
   ~Aquarium();
   bool init(int argc, char **argv);
-  void display();
+  // Return false if the fish simulation check fails.
+  bool display();
   Texture *getSkybox() { return mTextureMap["skybox"]; }
   int getCurFishCount() const { return mCurFishCount; }
   int getPreFishCount() const { return mPreFishCount; }
+  const FishSimulation *getFishSimulation() const { return mFishSimulation; }
 
   std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> toggleBitset;
   LightWorldPositionUniform lightWorldPositionUniform;
@@ -503,13 +591,33 @@ public:
 
 private:
   void render();
+  bool renderFrames(int frameCount);
+  void runUploadBenchmark();
+  // Render frames of the phase and record them if recorder isn't null.
+  // Return false if the window is closed.
+  bool renderBenchmarkPhase(const BenchmarkPhase &phase,
+                            FrameTimeRecorder *recorder);
+  void runBenchmark();
+  void writeBenchmarkJson(std::ostream &stream,
+                          const FrameTimeRecorder &recorder) const;
+  void writeBenchmarkCsv(std::ostream &stream,
+                         const FrameTimeRecorder &recorder) const;
+  void runFindMaxFish();
+  // Render fishCount fishes in the warmup and measure phases of the
+  // benchmark, print statistics of the measure phase and check if they meet
+  // the target fps. Return false if the window is closed.
+  bool measureFishCount(int fishCount, bool *stable);
+  bool checkFishSimulation();
   void loadReource();
   void loadPlacement();
   void loadModels();
   void loadFishScenario();
-  void loadModel(const G_sceneInfo &info);
+  void loadMesh(const G_sceneInfo &info, MeshCache *mesh) const;
+  void loadModel(const G_sceneInfo &info, const MeshCache &mesh);
   void setupModelEnumMap();
   void calculateFishCount();
+  void generateFishParams();
+  void getFishConstants(int fishType, FishConstants *constants) const;
   void updateGlobalUniforms();
 
   BACKENDTYPE getBackendType(const std::string &backendPath);
@@ -529,8 +637,21 @@ private:
   int mTestTime;
   BACKENDTYPE mBackendType;
   ContextFactory *mFactory;
+  FishSimulation *mFishSimulation;
+  JobSystem *mJobSystem;
   std::vector<std::string> mSkyUrls;
   std::queue<Behavior *> mFishBehavior;
+  std::vector<int> mUploadBenchmarkFishCounts;
+
+  std::string mBackendName;
+  bool mBenchmark;
+  std::string mBenchmarkPhases;
+  BenchmarkPhase mBenchmarkWarmup;
+  BenchmarkPhase mBenchmarkMeasure;
+  std::string mBenchmarkOutputPath;
+  // Target fps of the max fish count search, 0 if it's not run.
+  double mFindMaxFishFps;
+  bool mCheckFishSimulation;
 };
 
 #endif  // AQUARIUM_H
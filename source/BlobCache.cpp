@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BlobCache.cpp: Implement the content addressed blob cache.
+
+#include "BlobCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "MappedFile.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'Q', 'B', 'C'};
+
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t keySize;
+  uint64_t blobSize;
+};
+
+}  // namespace
+
+BlobCache::BlobCache(const std::string &folder, const std::string &prefix)
+    : mFolder(folder), mPrefix(prefix) {}
+
+uint64_t BlobCache::hash(const void *data, size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  uint64_t result = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; ++i) {
+    result ^= bytes[i];
+    result *= 0x100000001b3ull;
+  }
+  return result;
+}
+
+std::string BlobCache::getBlobPath(const std::string &key) const {
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx",
+           static_cast<unsigned long long>(hash(key.data(), key.size())));
+  return mFolder + mPrefix + name;
+}
+
+bool BlobCache::load(const std::string &key, std::vector<char> *blob) const {
+  MappedFile file;
+  if (!file.open(getBlobPath(key)) || file.getSize() < sizeof(FileHeader)) {
+    return false;
+  }
+
+  const FileHeader *header =
+      reinterpret_cast<const FileHeader *>(file.getData());
+  size_t payloadSize = file.getSize() - sizeof(FileHeader);
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kVersion || header->keySize != key.size() ||
+      header->keySize > payloadSize ||
+      header->blobSize != payloadSize - header->keySize) {
+    return false;
+  }
+
+  const char *payload = file.getData() + sizeof(FileHeader);
+  if (memcmp(payload, key.data(), key.size()) != 0) {
+    return false;
+  }
+  blob->assign(payload + key.size(), payload + payloadSize);
+  return true;
+}
+
+bool BlobCache::store(const std::string &key,
+                      const void *data,
+                      size_t size) const {
+  FileHeader header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.keySize = key.size();
+  header.blobSize = size;
+
+  std::string path = getBlobPath(key);
+  std::string tempPath = path + ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary);
+    if (!stream) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(key.data(), key.size());
+    stream.write(static_cast<const char *>(data), size);
+    if (!stream) {
+      return false;
+    }
+  }
+
+  return replaceFile(tempPath, path);
+}
@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BlobCache.h: Define a content addressed cache of binary blobs, such as
+// compiled shaders. A blob is stored in a file named by the hash of its key,
+// together with the key itself, so that a hash collision is a miss rather
+// than a wrong blob.
+
+#ifndef BLOBCACHE_H
+#define BLOBCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BlobCache {
+public:
+  // Bump it whenever the layout of the cache files changes.
+  static constexpr uint32_t kVersion = 1;
+
+  // Blobs are stored in folder as <prefix><hash of key>.
+  BlobCache(const std::string &folder, const std::string &prefix);
+
+  // Return false if there isn't a blob for key.
+  bool load(const std::string &key, std::vector<char> *blob) const;
+  bool store(const std::string &key, const void *data, size_t size) const;
+
+  // 64 bit FNV-1a.
+  static uint64_t hash(const void *data, size_t size);
+
+private:
+  std::string getBlobPath(const std::string &key) const;
+
+  std::string mFolder;
+  std::string mPrefix;
+};
+
+#endif  // BLOBCACHE_H
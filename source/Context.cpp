@@ -13,6 +13,13 @@
 #include "imgui_internal.h"
 
 #include "Aquarium.h"
+#include "Model.h"
+
+void Context::drawBackground(Model *const *models, int count) {
+  for (int i = 0; i < count; ++i) {
+    models[i]->draw();
+  }
+}
 
 void Context::renderImgui(
     const FPSTimer &fpsTimer,
@@ -123,6 +130,8 @@ void Context::renderImgui(
       }
     }
 
+    renderImguiStats();
+
     ImGui::Checkbox("Option Window", &show_option_window);
 
     ImGui::End();
@@ -36,15 +36,21 @@ public:
       const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
       int windowWidth,
       int windowHeight) = 0;
+  // Create a texture without loading it. Call loadTexture() on it to upload
+  // the images, after prepareTexture() has decoded them on any thread.
   virtual Texture *createTexture(const std::string &name,
                                  const std::string &url) = 0;
   virtual Texture *createTexture(const std::string &name,
                                  const std::vector<std::string> &urls) = 0;
+  // Create a buffer of totalComponents elements. The data is only read
+  // during the call, so it can point to mapped memory.
   virtual Buffer *createBuffer(int numComponents,
-                               std::vector<float> *buffer,
+                               const float *buffer,
+                               int totalComponents,
                                bool isIndex) = 0;
   virtual Buffer *createBuffer(int numComponents,
-                               std::vector<unsigned short> *buffer,
+                               const unsigned short *buffer,
+                               int totalComponents,
                                bool isIndex) = 0;
   virtual Program *createProgram(const std::string &mVId,
                                  const std::string &mFId) = 0;
@@ -69,6 +75,9 @@ public:
                                bool enableDynamicBufferOffset) {}
   virtual void updateAllFishData() = 0;
   virtual void beginRenderPass() {}
+  // Draw background models in draw per model mode. Their draw calls don't
+  // change from frame to frame, only the contents of their uniforms do.
+  virtual void drawBackground(Model *const *models, int count);
 
   int getClientWidth() const { return mClientWidth; }
   int getclientHeight() const { return mClientHeight; }
@@ -84,6 +93,16 @@ public:
 
   virtual void initGeneralResources(Aquarium *aquarium) {}
   virtual void updateWorldlUniforms(Aquarium *aquarium) {}
+  // Upload per fish parameters after the fish count changes, for backends
+  // that simulate fishes on gpu.
+  virtual void updateFishParams(Aquarium *aquarium) {}
+
+  // Choose how per frame data is uploaded. It can be called before
+  // initialize() or between frames. Return false if the backend doesn't
+  // implement the strategy.
+  virtual bool setUploadStrategy(UPLOADSTRATEGY strategy) { return false; }
+  virtual UploadStats getUploadStats() const { return UploadStats(); }
+  virtual void resetUploadStats() {}
 
   ResourceHelper *getResourceHelper() { return mResourceHelper; }
   void setMSAASampleCount(int MSAASampleCount) {
@@ -96,6 +115,13 @@ protected:
       int *fishCount,
       std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> *toggleBitset);
   void setWindowSize(int windowWidth, int windowHeight);
+  // Show backend specific statistics in the control panel.
+  virtual void renderImguiStats() {}
+
+  // Size of the offscreen render target in headless mode, unless the window
+  // size is designated.
+  static constexpr int kHeadlessWidth = 1920;
+  static constexpr int kHeadlessHeight = 1080;
 
   int mClientWidth;
   int mClientHeight;
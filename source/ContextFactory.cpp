@@ -7,6 +7,7 @@
 #include "ContextFactory.h"
 
 #include "Aquarium.h"
+#include "null/ContextNull.h"
 #include "opengl/ContextGL.h"
 #ifdef ENABLE_DAWN_BACKEND
 #include "dawn/ContextDawn.h"
@@ -39,6 +40,8 @@ Context *ContextFactory::createContext(BACKENDTYPE backendType) {
 #if defined(ENABLE_OPENGL_BACKEND)
     mContext = ContextGL::create(backendType);
 #endif
+  } else if (backendType & BACKENDTYPE::BACKENDTYPENULL) {
+    mContext = ContextNull::create(backendType);
   }
   return mContext;
 }
@@ -8,6 +8,10 @@
 #include "FishModel.h"
 
 void FishModel::prepareForDraw() {
+  updateInstanceRange();
+}
+
+void FishModel::updateInstanceRange() {
   mFishPerOffset = 0;
   for (int i = 0; i < mName - MODELNAME::MODELSMALLFISHA; i++) {
     const Fish &fishInfo = fishTable[i];
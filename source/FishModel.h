@@ -28,7 +28,13 @@ public:
                                      float scale,
                                      float time,
                                      int index) = 0;
-  void prepareForDraw();
+  // Return the FishPer array of the model if the backend keeps one, fish
+  // simulation writes results to it directly. Backends that return nullptr
+  // get results by updateFishPerUniforms.
+  virtual FishPer *getFishPers() { return nullptr; }
+  void prepareForDraw() override;
+  // Compute the range of the fish type in the FishPer array of all fishes.
+  void updateInstanceRange();
 
 protected:
   int mPreInstance;
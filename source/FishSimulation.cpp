@@ -0,0 +1,296 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishSimulation.cpp: Implement the scalar reference kernel of fish
+// simulation, and choose SIMD kernels according to cpu features.
+
+#include "FishSimulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Assert.h"
+#include "JobSystem.h"
+#include "Trace.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#if defined(OS_WIN)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+#if defined(ARCH_CPU_X86_FAMILY)
+void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(OS_WIN)
+  __cpuidex(reinterpret_cast<int *>(regs), leaf, subleaf);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Read XCR0 to check if the OS saves the extended registers on context
+// switch.
+unsigned long long xgetbv() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return _xgetbv(0);
+#else
+  unsigned int eax;
+  unsigned int edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+FishKernel getKernel(SIMDISA isa) {
+  switch (isa) {
+#if defined(ARCH_CPU_X86_FAMILY)
+  case SIMDISA::SIMDSSE4:
+    return updateFishSSE4;
+  case SIMDISA::SIMDAVX2:
+    return updateFishAVX2;
+  case SIMDISA::SIMDAVX512:
+    return updateFishAVX512;
+#endif
+  default:
+    return updateFishScalar;
+  }
+}
+
+}  // namespace
+
+// The reference implementation. It matches the per fish loop of
+// Aquarium::updateAndDraw bit by bit.
+void updateFishScalar(const FishConstants &constants,
+                      const FishParams &params,
+                      int begin,
+                      int end,
+                      FishPer *fishPers) {
+  for (int i = begin; i < end; ++i) {
+    float fishClock = constants.fishBaseClock + i * constants.fishOffset;
+    float speed = params.speed[i];
+    float xRadius = params.xRadius[i];
+    float yRadius = params.yRadius[i];
+    float zRadius = params.zRadius[i];
+    float fishSpeedClock = fishClock * speed;
+    float xClock = fishSpeedClock * constants.fishXClock;
+    float yClock = fishSpeedClock * constants.fishYClock;
+    float zClock = fishSpeedClock * constants.fishZClock;
+
+    FishPer &fishPer = fishPers[i];
+    fishPer.worldPosition[0] = std::sin(xClock) * xRadius;
+    fishPer.worldPosition[1] =
+        std::sin(yClock) * yRadius + constants.fishHeight;
+    fishPer.worldPosition[2] = std::cos(zClock) * zRadius;
+    fishPer.nextPosition[0] = std::sin(xClock - 0.04f) * xRadius;
+    fishPer.nextPosition[1] =
+        std::sin(yClock - 0.01f) * yRadius + constants.fishHeight;
+    fishPer.nextPosition[2] = std::cos(zClock - 0.04f) * zRadius;
+    fishPer.scale = params.scale[i];
+    fishPer.time = std::fmod((constants.clock + i * constants.tailOffsetMult) *
+                                 constants.fishTailSpeed * speed,
+                             static_cast<float>(M_PI) * 2);
+  }
+}
+
+FishSimulation::FishSimulation()
+    : mIsa(SIMDISA::SIMDSCALAR), mKernel(updateFishScalar), mFishCount() {
+  setSimdIsa(getBestSimdIsa());
+}
+
+bool FishSimulation::isSimdIsaSupported(SIMDISA isa) {
+  if (isa == SIMDISA::SIMDSCALAR) {
+    return true;
+  }
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  unsigned int regs[4];
+  cpuid(0, 0, regs);
+  unsigned int maxLeaf = regs[0];
+
+  cpuid(1, 0, regs);
+  bool sse41 = (regs[2] & (1u << 19)) != 0;
+  bool fma = (regs[2] & (1u << 12)) != 0;
+  bool osxsave = (regs[2] & (1u << 27)) != 0;
+  bool avx = (regs[2] & (1u << 28)) != 0;
+  if (isa == SIMDISA::SIMDSSE4) {
+    return sse41;
+  }
+
+  if (!sse41 || !fma || !osxsave || !avx || maxLeaf < 7) {
+    return false;
+  }
+
+  // XMM and YMM state are required by AVX2, opmask and ZMM state are
+  // required by AVX-512 in addition.
+  unsigned long long xcr0 = xgetbv();
+  cpuid(7, 0, regs);
+  bool avx2 = (regs[1] & (1u << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+  bool avx512f = (regs[1] & (1u << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+  if (isa == SIMDISA::SIMDAVX2) {
+    return avx2;
+  }
+  if (isa == SIMDISA::SIMDAVX512) {
+    return avx2 && avx512f;
+  }
+#endif
+
+  return false;
+}
+
+SIMDISA FishSimulation::getBestSimdIsa() {
+  for (int isa = SIMDISA::SIMDMAX - 1; isa > SIMDISA::SIMDSCALAR; --isa) {
+    if (isSimdIsaSupported(static_cast<SIMDISA>(isa))) {
+      return static_cast<SIMDISA>(isa);
+    }
+  }
+  return SIMDISA::SIMDSCALAR;
+}
+
+const char *FishSimulation::getSimdIsaName(SIMDISA isa) {
+  switch (isa) {
+  case SIMDISA::SIMDSSE4:
+    return "sse4";
+  case SIMDISA::SIMDAVX2:
+    return "avx2";
+  case SIMDISA::SIMDAVX512:
+    return "avx512";
+  default:
+    return "scalar";
+  }
+}
+
+SIMDISA FishSimulation::getSimdIsaByName(const std::string &name) {
+  for (int isa = SIMDISA::SIMDSCALAR; isa < SIMDISA::SIMDMAX; ++isa) {
+    if (name == getSimdIsaName(static_cast<SIMDISA>(isa))) {
+      return static_cast<SIMDISA>(isa);
+    }
+  }
+  return SIMDISA::SIMDMAX;
+}
+
+bool FishSimulation::setSimdIsa(SIMDISA isa) {
+  if (isa >= SIMDISA::SIMDMAX || !isSimdIsaSupported(isa)) {
+    return false;
+  }
+
+  mIsa = isa;
+  mKernel = getKernel(isa);
+  return true;
+}
+
+void FishSimulation::resize(int fishType, int numFish) {
+  ASSERT(fishType >= 0 && fishType < NUM_FISH_TYPES);
+  mFishCount[fishType] = numFish;
+
+  // Kernels load a full vector at the last fish.
+  size_t paddedSize = numFish + kMaxSimdWidth - 1;
+  if (mSpeed[fishType].size() == paddedSize) {
+    return;
+  }
+
+  mSpeed[fishType].resize(paddedSize, 0.0f);
+  mScale[fishType].resize(paddedSize, 0.0f);
+  mXRadius[fishType].resize(paddedSize, 0.0f);
+  mYRadius[fishType].resize(paddedSize, 0.0f);
+  mZRadius[fishType].resize(paddedSize, 0.0f);
+}
+
+void FishSimulation::update(int fishType,
+                            const FishConstants &constants,
+                            int begin,
+                            int end,
+                            FishPer *fishPers) const {
+  ASSERT(end <= mFishCount[fishType]);
+  mKernel(constants, getParams(fishType), begin, end, fishPers);
+}
+
+void FishSimulation::updateAll(const FishConstants constants[NUM_FISH_TYPES],
+                               FishPer *const fishPers[NUM_FISH_TYPES],
+                               JobSystem *jobSystem) {
+  int totalFish = 0;
+  for (int fishType = 0; fishType < NUM_FISH_TYPES; ++fishType) {
+    totalFish += mFishCount[fishType];
+  }
+
+  // Aim at a few chunks per thread so that stealing can balance the load.
+  // Chunks are aligned to the widest kernel to keep all lanes busy.
+  int chunkSize = totalFish / (jobSystem->getThreadCount() * 4);
+  chunkSize = (chunkSize + kMaxSimdWidth - 1) / kMaxSimdWidth * kMaxSimdWidth;
+  chunkSize = std::max(chunkSize, kMinChunkSize);
+
+  mChunks.clear();
+  for (int fishType = 0; fishType < NUM_FISH_TYPES; ++fishType) {
+    for (int begin = 0; begin < mFishCount[fishType]; begin += chunkSize) {
+      Chunk chunk;
+      chunk.fishType = fishType;
+      chunk.begin = begin;
+      chunk.end = std::min(begin + chunkSize, mFishCount[fishType]);
+      mChunks.push_back(chunk);
+    }
+  }
+
+  jobSystem->parallelFor(
+      static_cast<int>(mChunks.size()), [&](int index) {
+        TRACE_SCOPE("simulateFishChunk");
+        const Chunk &chunk = mChunks[index];
+        update(chunk.fishType, constants[chunk.fishType], chunk.begin,
+               chunk.end, fishPers[chunk.fishType]);
+      });
+}
+
+float FishSimulation::compareWithScalar(SIMDISA isa,
+                                        int fishType,
+                                        const FishConstants &constants) const {
+  int numFish = mFishCount[fishType];
+  FishParams params = getParams(fishType);
+  std::vector<FishPer> reference(numFish);
+  std::vector<FishPer> result(numFish);
+  updateFishScalar(constants, params, 0, numFish, reference.data());
+  getKernel(isa)(constants, params, 0, numFish, result.data());
+
+  float maxDifference = 0.0f;
+  for (int i = 0; i < numFish; ++i) {
+    const FishPer &expected = reference[i];
+    const FishPer &actual = result[i];
+    for (int k = 0; k < 3; ++k) {
+      maxDifference = std::max(
+          maxDifference,
+          std::abs(expected.worldPosition[k] - actual.worldPosition[k]));
+      maxDifference = std::max(
+          maxDifference,
+          std::abs(expected.nextPosition[k] - actual.nextPosition[k]));
+    }
+    maxDifference =
+        std::max(maxDifference, std::abs(expected.scale - actual.scale));
+    float timeDifference = std::abs(expected.time - actual.time);
+    timeDifference = std::min(timeDifference,
+                              static_cast<float>(M_PI) * 2 - timeDifference);
+    maxDifference = std::max(maxDifference, timeDifference);
+  }
+  return maxDifference;
+}
+
+FishParams FishSimulation::getParams(int fishType) const {
+  FishParams params;
+  params.speed = mSpeed[fishType].data();
+  params.scale = mScale[fishType].data();
+  params.xRadius = mXRadius[fishType].data();
+  params.yRadius = mYRadius[fishType].data();
+  params.zRadius = mZRadius[fishType].data();
+  return params;
+}
+
+FishPer *FishSimulation::getScratchFishPers(int fishType) {
+  std::vector<FishPer> &scratchFishPers = mScratchFishPers[fishType];
+  if (scratchFishPers.size() < static_cast<size_t>(mFishCount[fishType])) {
+    scratchFishPers.resize(mFishCount[fishType]);
+  }
+  return scratchFishPers.data();
+}
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishSimulation.h: Define fish simulation. Keep per fish parameters as
+// structure of arrays and update fish positions by SIMD kernels that are
+// chosen at runtime.
+
+#ifndef FISHSIMULATION_H
+#define FISHSIMULATION_H
+
+#include <string>
+#include <vector>
+
+#include "build/build_config.h"
+
+#include "Aquarium.h"
+
+class JobSystem;
+
+constexpr int NUM_FISH_TYPES =
+    MODELNAME::MODELBIGFISHB - MODELNAME::MODELSMALLFISHA + 1;
+
+enum SIMDISA : short {
+  SIMDSCALAR,
+  SIMDSSE4,
+  SIMDAVX2,
+  SIMDAVX512,
+  SIMDMAX
+};
+
+// Constants shared by all of the fishes of a fish type in a frame.
+struct FishConstants {
+  float fishBaseClock;
+  float fishOffset;
+  float fishHeight;
+  float fishXClock;
+  float fishYClock;
+  float fishZClock;
+  float fishTailSpeed;
+  float clock;
+  float tailOffsetMult;
+};
+
+// Per fish parameters of a fish type, each array holds one value per fish.
+struct FishParams {
+  const float *speed;
+  const float *scale;
+  const float *xRadius;
+  const float *yRadius;
+  const float *zRadius;
+};
+
+// Update fishes [begin, end) and write the results to fishPers[begin, end).
+typedef void (*FishKernel)(const FishConstants &constants,
+                           const FishParams &params,
+                           int begin,
+                           int end,
+                           FishPer *fishPers);
+
+void updateFishScalar(const FishConstants &constants,
+                      const FishParams &params,
+                      int begin,
+                      int end,
+                      FishPer *fishPers);
+#if defined(ARCH_CPU_X86_FAMILY)
+void updateFishSSE4(const FishConstants &constants,
+                    const FishParams &params,
+                    int begin,
+                    int end,
+                    FishPer *fishPers);
+void updateFishAVX2(const FishConstants &constants,
+                    const FishParams &params,
+                    int begin,
+                    int end,
+                    FishPer *fishPers);
+void updateFishAVX512(const FishConstants &constants,
+                      const FishParams &params,
+                      int begin,
+                      int end,
+                      FishPer *fishPers);
+#endif
+
+class FishSimulation {
+public:
+  // The widest SIMD kernel processes this many fishes at a time. Parameter
+  // arrays are padded by kMaxSimdWidth - 1 elements so that kernels never
+  // read out of bounds.
+  static constexpr int kMaxSimdWidth = 16;
+  // Chunks smaller than this cost more to schedule than to compute.
+  static constexpr int kMinChunkSize = 512;
+
+  FishSimulation();
+
+  static bool isSimdIsaSupported(SIMDISA isa);
+  static SIMDISA getBestSimdIsa();
+  static const char *getSimdIsaName(SIMDISA isa);
+  static SIMDISA getSimdIsaByName(const std::string &name);
+
+  // Return false if the instruction set isn't supported by the cpu.
+  bool setSimdIsa(SIMDISA isa);
+  SIMDISA getSimdIsa() const { return mIsa; }
+
+  // Resize parameter arrays of a fish type to hold numFish fishes.
+  void resize(int fishType, int numFish);
+  int getFishCount(int fishType) const { return mFishCount[fishType]; }
+
+  float *getSpeed(int fishType) { return mSpeed[fishType].data(); }
+  float *getScale(int fishType) { return mScale[fishType].data(); }
+  float *getXRadius(int fishType) { return mXRadius[fishType].data(); }
+  float *getYRadius(int fishType) { return mYRadius[fishType].data(); }
+  float *getZRadius(int fishType) { return mZRadius[fishType].data(); }
+  const float *getSpeed(int fishType) const { return mSpeed[fishType].data(); }
+  const float *getScale(int fishType) const { return mScale[fishType].data(); }
+  const float *getXRadius(int fishType) const {
+    return mXRadius[fishType].data();
+  }
+  const float *getYRadius(int fishType) const {
+    return mYRadius[fishType].data();
+  }
+  const float *getZRadius(int fishType) const {
+    return mZRadius[fishType].data();
+  }
+
+  void update(int fishType,
+              const FishConstants &constants,
+              int begin,
+              int end,
+              FishPer *fishPers) const;
+  // Update all fish types. Each fish type is split into chunks that write
+  // disjoint ranges of fishPers[fishType], and chunks are run by jobSystem.
+  // Fishes are computed independently of each other, so results don't depend
+  // on how the chunks are scheduled.
+  void updateAll(const FishConstants constants[NUM_FISH_TYPES],
+                 FishPer *const fishPers[NUM_FISH_TYPES],
+                 JobSystem *jobSystem);
+  // Update the fishes of a fish type by the kernel of isa and by the scalar
+  // reference, and return the largest difference of their results. Tail
+  // times are compared modulo 2 * pi.
+  float compareWithScalar(SIMDISA isa,
+                          int fishType,
+                          const FishConstants &constants) const;
+
+  // Scratch output of a fish type for backends that don't keep a FishPer
+  // array.
+  FishPer *getScratchFishPers(int fishType);
+
+private:
+  FishParams getParams(int fishType) const;
+
+  SIMDISA mIsa;
+  FishKernel mKernel;
+
+  int mFishCount[NUM_FISH_TYPES];
+  std::vector<float> mSpeed[NUM_FISH_TYPES];
+  std::vector<float> mScale[NUM_FISH_TYPES];
+  std::vector<float> mXRadius[NUM_FISH_TYPES];
+  std::vector<float> mYRadius[NUM_FISH_TYPES];
+  std::vector<float> mZRadius[NUM_FISH_TYPES];
+
+  std::vector<FishPer> mScratchFishPers[NUM_FISH_TYPES];
+
+  struct Chunk {
+    int fishType;
+    int begin;
+    int end;
+  };
+  std::vector<Chunk> mChunks;
+};
+
+#endif  // FISHSIMULATION_H
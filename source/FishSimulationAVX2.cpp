@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishSimulationAVX2.cpp: Implement the fish simulation kernel by AVX2 and
+// FMA. This file is compiled with -mavx2 -mfma.
+
+#include <immintrin.h>
+
+#include "FishSimulationKernel.h"
+
+namespace {
+
+struct SimdAVX2 {
+  typedef __m256 Float;
+  typedef __m256i Int;
+  static constexpr int kWidth = 8;
+  static constexpr bool kHasFma = true;
+
+  static Float set1(float value) { return _mm256_set1_ps(value); }
+  static Float setIndex(int begin) {
+    return _mm256_cvtepi32_ps(
+        _mm256_add_epi32(_mm256_set1_epi32(begin),
+                         _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+  }
+  static Float load(const float *p) { return _mm256_loadu_ps(p); }
+  static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+  static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+  static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+  static Float mulAdd(Float a, Float b, Float c) {
+    return _mm256_fmadd_ps(a, b, c);
+  }
+  static Float negMulAdd(Float a, Float b, Float c) {
+    return _mm256_fnmadd_ps(a, b, c);
+  }
+  static Float round(Float a) {
+    return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+  static Float floor(Float a) { return _mm256_floor_ps(a); }
+  static Int toInt(Float a) { return _mm256_cvttps_epi32(a); }
+  static Int addInt(Int a, int b) {
+    return _mm256_add_epi32(a, _mm256_set1_epi32(b));
+  }
+  static Float selectQuadrant(Int quadrant, Float sinPoly, Float cosPoly) {
+    Int one = _mm256_set1_epi32(1);
+    Float odd = _mm256_castsi256_ps(
+        _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+    Float sign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+    return _mm256_xor_ps(_mm256_blendv_ps(sinPoly, cosPoly, odd), sign);
+  }
+  static void storeFishPers(FishPer *fishPers, int count, const Float rows[8]) {
+    fishkernel::storeFishPers8x8(fishPers, count, rows);
+  }
+};
+
+}  // namespace
+
+void updateFishAVX2(const FishConstants &constants,
+                    const FishParams &params,
+                    int begin,
+                    int end,
+                    FishPer *fishPers) {
+  fishkernel::updateFish<SimdAVX2>(constants, params, begin, end, fishPers);
+}
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishSimulationAVX512.cpp: Implement the fish simulation kernel by
+// AVX-512F. This file is compiled with -mavx512f -mavx2 -mfma.
+
+#include <immintrin.h>
+
+#include "FishSimulationKernel.h"
+
+namespace {
+
+struct SimdAVX512 {
+  typedef __m512 Float;
+  typedef __m512i Int;
+  static constexpr int kWidth = 16;
+  static constexpr bool kHasFma = true;
+
+  static Float set1(float value) { return _mm512_set1_ps(value); }
+  static Float setIndex(int begin) {
+    return _mm512_cvtepi32_ps(_mm512_add_epi32(
+        _mm512_set1_epi32(begin),
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                          15)));
+  }
+  static Float load(const float *p) { return _mm512_loadu_ps(p); }
+  static Float add(Float a, Float b) { return _mm512_add_ps(a, b); }
+  static Float sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+  static Float mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+  static Float mulAdd(Float a, Float b, Float c) {
+    return _mm512_fmadd_ps(a, b, c);
+  }
+  static Float negMulAdd(Float a, Float b, Float c) {
+    return _mm512_fnmadd_ps(a, b, c);
+  }
+  static Float round(Float a) {
+    return _mm512_roundscale_ps(a,
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+  static Float floor(Float a) {
+    return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+  static Int toInt(Float a) { return _mm512_cvttps_epi32(a); }
+  static Int addInt(Int a, int b) {
+    return _mm512_add_epi32(a, _mm512_set1_epi32(b));
+  }
+  static Float selectQuadrant(Int quadrant, Float sinPoly, Float cosPoly) {
+    __mmask16 odd = _mm512_test_epi32_mask(quadrant, _mm512_set1_epi32(1));
+    Int sign = _mm512_slli_epi32(
+        _mm512_and_si512(quadrant, _mm512_set1_epi32(2)), 30);
+    Float result = _mm512_mask_blend_ps(odd, sinPoly, cosPoly);
+    return _mm512_castsi512_ps(
+        _mm512_xor_si512(_mm512_castps_si512(result), sign));
+  }
+  static void storeFishPers(FishPer *fishPers, int count, const Float rows[8]) {
+    __m256 low[8];
+    __m256 high[8];
+    for (int k = 0; k < 8; ++k) {
+      low[k] = _mm512_castps512_ps256(rows[k]);
+      high[k] = _mm256_castpd_ps(
+          _mm512_extractf64x4_pd(_mm512_castps_pd(rows[k]), 1));
+    }
+    fishkernel::storeFishPers8x8(fishPers, count < 8 ? count : 8, low);
+    if (count > 8) {
+      fishkernel::storeFishPers8x8(fishPers + 8, count - 8, high);
+    }
+  }
+};
+
+}  // namespace
+
+void updateFishAVX512(const FishConstants &constants,
+                      const FishParams &params,
+                      int begin,
+                      int end,
+                      FishPer *fishPers) {
+  fishkernel::updateFish<SimdAVX512>(constants, params, begin, end, fishPers);
+}
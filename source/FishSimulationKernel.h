@@ -0,0 +1,228 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishSimulationKernel.h: Define the SIMD kernel of fish simulation. The
+// kernel is written once against a traits struct S, each instruction set
+// provides its traits struct and instantiates the kernel in its own
+// translation unit, which is compiled with the matching target flags.
+//
+// S should provide:
+//   Float, Int          vector types of S::kWidth lanes.
+//   kHasFma             whether mulAdd and negMulAdd are fused.
+//   set1, setIndex      broadcast a float, lane indices as floats.
+//   load                unaligned load.
+//   add, sub, mul       arithmetic.
+//   mulAdd, negMulAdd   a * b + c and c - a * b.
+//   round, floor        round to nearest even and round down.
+//   toInt               convert integral floats to int.
+//   addInt              add an int to each lane.
+//   selectQuadrant      pick cosPoly for odd quadrants, sinPoly for even
+//                       ones, and negate the result of quadrants 2 and 3.
+//   storeFishPers       transpose 8 rows of results and store them to count
+//                       consecutive FishPer.
+//
+// Accuracy: sin and cos use Cody-Waite reduction by pi/2 and the minimax
+// polynomials of Cephes. pi/2 is split into three parts of 12 bits and a
+// remainder. With FMA each product is subtracted with a single rounding.
+// Without FMA the quotient is split into two halves of 12 bits as well, so
+// that the product of each half and each part of 12 bits is exact. Either way
+// the reduced argument is within 1.2e-7 of the exact one for quotients below
+// 2^24, which covers the arguments of millions of fishes, and the result is
+// within 5e-7 of std::sin and std::cos. The tail time is reduced the same way
+// by floor instead of fmod, so it matches the scalar reference exactly,
+// except that it lands on 0 or 2 * pi when the scalar result is within a few
+// ulp of either.
+//
+// The kernels must be compiled with -ffp-contract=off, the arguments of sin
+// and cos are large and fusing their multiply-add changes the result by far
+// more than the bound above.
+
+#ifndef FISHSIMULATIONKERNEL_H
+#define FISHSIMULATIONKERNEL_H
+
+#include <algorithm>
+
+#include "FishSimulation.h"
+
+namespace fishkernel {
+
+constexpr float kTwoOverPi = 0.636619772367581343f;
+constexpr float kPiOver2A = 1.5703125f;
+constexpr float kPiOver2B = 4.837512969970703125e-4f;
+constexpr float kPiOver2C = 7.549533620476723e-8f;
+constexpr float kPiOver2D = 2.5633440682570896e-12f;
+// Quotients are split at this power of two without FMA.
+constexpr float kQuotientSplit = 4096.0f;
+constexpr float kSinC1 = -1.6666654611e-1f;
+constexpr float kSinC2 = 8.3321608736e-3f;
+constexpr float kSinC3 = -1.9515295891e-4f;
+constexpr float kCosC1 = 4.166664568298827e-2f;
+constexpr float kCosC2 = -1.388731625493765e-3f;
+constexpr float kCosC3 = 2.443315711809948e-5f;
+// The scalar reference reduces by the float value of 2 * pi, split it into
+// parts of 8 and 12 bits so that their products with the quotient, or with
+// its halves without FMA, are exact.
+constexpr float kTwoPi = static_cast<float>(M_PI) * 2;
+constexpr float kTwoPiA = 6.28125f;
+constexpr float kTwoPiB = kTwoPi - kTwoPiA;
+constexpr float kInvTwoPi = static_cast<float>(1.0 / (M_PI * 2));
+
+// Return the high half of an integral quotient, which keeps its bits above
+// kQuotientSplit. The low half is exact by subtracting it from the quotient.
+template <typename S>
+inline typename S::Float splitHi(typename S::Float quotient) {
+  return S::mul(S::round(S::mul(quotient, S::set1(1.0f / kQuotientSplit))),
+                S::set1(kQuotientSplit));
+}
+
+// Compute sin(x) if quadrantOffset is 0, or cos(x) if it's 1.
+template <typename S>
+inline typename S::Float sinOrCos(typename S::Float x, int quadrantOffset) {
+  typename S::Float j = S::round(S::mul(x, S::set1(kTwoOverPi)));
+  typename S::Float r;
+  if (S::kHasFma) {
+    r = S::negMulAdd(j, S::set1(kPiOver2A), x);
+    r = S::negMulAdd(j, S::set1(kPiOver2B), r);
+    r = S::negMulAdd(j, S::set1(kPiOver2C + kPiOver2D), r);
+  } else {
+    typename S::Float jHi = splitHi<S>(j);
+    typename S::Float jLo = S::sub(j, jHi);
+    r = S::negMulAdd(jHi, S::set1(kPiOver2A), x);
+    r = S::negMulAdd(jLo, S::set1(kPiOver2A), r);
+    r = S::negMulAdd(jHi, S::set1(kPiOver2B), r);
+    r = S::negMulAdd(jLo, S::set1(kPiOver2B), r);
+    r = S::negMulAdd(jHi, S::set1(kPiOver2C), r);
+    r = S::negMulAdd(jLo, S::set1(kPiOver2C), r);
+    r = S::negMulAdd(j, S::set1(kPiOver2D), r);
+  }
+  typename S::Int quadrant = S::addInt(S::toInt(j), quadrantOffset);
+
+  typename S::Float z = S::mul(r, r);
+  typename S::Float sinPoly =
+      S::mulAdd(S::set1(kSinC3), z, S::set1(kSinC2));
+  sinPoly = S::mulAdd(sinPoly, z, S::set1(kSinC1));
+  sinPoly = S::mulAdd(S::mul(sinPoly, z), r, r);
+
+  typename S::Float cosPoly =
+      S::mulAdd(S::set1(kCosC3), z, S::set1(kCosC2));
+  cosPoly = S::mulAdd(cosPoly, z, S::set1(kCosC1));
+  cosPoly = S::mul(S::mul(cosPoly, z), z);
+  cosPoly = S::negMulAdd(S::set1(0.5f), z, cosPoly);
+  cosPoly = S::add(cosPoly, S::set1(1.0f));
+
+  return S::selectQuadrant(quadrant, sinPoly, cosPoly);
+}
+
+template <typename S>
+void updateFish(const FishConstants &constants,
+                const FishParams &params,
+                int begin,
+                int end,
+                FishPer *fishPers) {
+  const typename S::Float fishBaseClock = S::set1(constants.fishBaseClock);
+  const typename S::Float fishOffset = S::set1(constants.fishOffset);
+  const typename S::Float fishHeight = S::set1(constants.fishHeight);
+  const typename S::Float fishXClock = S::set1(constants.fishXClock);
+  const typename S::Float fishYClock = S::set1(constants.fishYClock);
+  const typename S::Float fishZClock = S::set1(constants.fishZClock);
+  const typename S::Float fishTailSpeed = S::set1(constants.fishTailSpeed);
+  const typename S::Float clock = S::set1(constants.clock);
+  const typename S::Float tailOffsetMult = S::set1(constants.tailOffsetMult);
+  const typename S::Float xOffset = S::set1(0.04f);
+  const typename S::Float yOffset = S::set1(0.01f);
+  const typename S::Float zOffset = S::set1(0.04f);
+
+  for (int i = begin; i < end; i += S::kWidth) {
+    typename S::Float index = S::setIndex(i);
+    typename S::Float speed = S::load(params.speed + i);
+    typename S::Float xRadius = S::load(params.xRadius + i);
+    typename S::Float yRadius = S::load(params.yRadius + i);
+    typename S::Float zRadius = S::load(params.zRadius + i);
+
+    // Arguments are computed without fused multiply-add to round exactly as
+    // the scalar reference does.
+    typename S::Float fishClock =
+        S::add(S::mul(index, fishOffset), fishBaseClock);
+    typename S::Float fishSpeedClock = S::mul(fishClock, speed);
+    typename S::Float xClock = S::mul(fishSpeedClock, fishXClock);
+    typename S::Float yClock = S::mul(fishSpeedClock, fishYClock);
+    typename S::Float zClock = S::mul(fishSpeedClock, fishZClock);
+
+    typename S::Float time = S::mul(
+        S::mul(S::add(S::mul(index, tailOffsetMult), clock), fishTailSpeed),
+        speed);
+    typename S::Float quotient = S::floor(S::mul(time, S::set1(kInvTwoPi)));
+    if (S::kHasFma) {
+      time = S::negMulAdd(quotient, S::set1(kTwoPiA), time);
+      time = S::negMulAdd(quotient, S::set1(kTwoPiB), time);
+    } else {
+      typename S::Float quotientHi = splitHi<S>(quotient);
+      typename S::Float quotientLo = S::sub(quotient, quotientHi);
+      time = S::negMulAdd(quotientHi, S::set1(kTwoPiA), time);
+      time = S::negMulAdd(quotientLo, S::set1(kTwoPiA), time);
+      time = S::negMulAdd(quotientHi, S::set1(kTwoPiB), time);
+      time = S::negMulAdd(quotientLo, S::set1(kTwoPiB), time);
+    }
+
+    // Rows are laid out as FishPer: worldPosition, scale, nextPosition and
+    // time.
+    typename S::Float rows[8];
+    rows[0] = S::mul(sinOrCos<S>(xClock, 0), xRadius);
+    rows[1] = S::mulAdd(sinOrCos<S>(yClock, 0), yRadius, fishHeight);
+    rows[2] = S::mul(sinOrCos<S>(zClock, 1), zRadius);
+    rows[3] = S::load(params.scale + i);
+    rows[4] = S::mul(sinOrCos<S>(S::sub(xClock, xOffset), 0), xRadius);
+    rows[5] =
+        S::mulAdd(sinOrCos<S>(S::sub(yClock, yOffset), 0), yRadius, fishHeight);
+    rows[6] = S::mul(sinOrCos<S>(S::sub(zClock, zOffset), 1), zRadius);
+    rows[7] = time;
+
+    S::storeFishPers(fishPers + i, std::min(S::kWidth, end - i), rows);
+  }
+}
+
+#if defined(__AVX__)
+// Transpose 8 rows of 8 floats and store the first count rows of the result
+// to consecutive FishPer.
+inline void storeFishPers8x8(FishPer *fishPers,
+                             int count,
+                             const __m256 rows[8]) {
+  __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+  __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+  __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+  __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+  __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+  __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+  __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+  __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+  __m256 columns[8];
+  columns[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  columns[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  columns[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  columns[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  columns[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  columns[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  columns[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  columns[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+
+  for (int k = 0; k < count; ++k) {
+    _mm256_storeu_ps(fishPers[k].worldPosition, columns[k]);
+  }
+}
+#endif
+
+}  // namespace fishkernel
+
+#endif  // FISHSIMULATIONKERNEL_H
@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishSimulationSSE4.cpp: Implement the fish simulation kernel by SSE4.1.
+// This file is compiled with -msse4.1.
+
+#include <smmintrin.h>
+
+#include "FishSimulationKernel.h"
+
+namespace {
+
+struct SimdSSE4 {
+  typedef __m128 Float;
+  typedef __m128i Int;
+  static constexpr int kWidth = 4;
+  static constexpr bool kHasFma = false;
+
+  static Float set1(float value) { return _mm_set1_ps(value); }
+  static Float setIndex(int begin) {
+    return _mm_cvtepi32_ps(
+        _mm_add_epi32(_mm_set1_epi32(begin), _mm_setr_epi32(0, 1, 2, 3)));
+  }
+  static Float load(const float *p) { return _mm_loadu_ps(p); }
+  static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+  static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+  static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+  static Float mulAdd(Float a, Float b, Float c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+  static Float negMulAdd(Float a, Float b, Float c) {
+    return _mm_sub_ps(c, _mm_mul_ps(a, b));
+  }
+  static Float round(Float a) {
+    return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+  static Float floor(Float a) { return _mm_floor_ps(a); }
+  static Int toInt(Float a) { return _mm_cvttps_epi32(a); }
+  static Int addInt(Int a, int b) {
+    return _mm_add_epi32(a, _mm_set1_epi32(b));
+  }
+  static Float selectQuadrant(Int quadrant, Float sinPoly, Float cosPoly) {
+    Int one = _mm_set1_epi32(1);
+    Float odd = _mm_castsi128_ps(
+        _mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+    Float sign = _mm_castsi128_ps(
+        _mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    return _mm_xor_ps(_mm_blendv_ps(sinPoly, cosPoly, odd), sign);
+  }
+  static void storeFishPers(FishPer *fishPers, int count, const Float rows[8]) {
+    Float r0 = rows[0], r1 = rows[1], r2 = rows[2], r3 = rows[3];
+    Float r4 = rows[4], r5 = rows[5], r6 = rows[6], r7 = rows[7];
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _MM_TRANSPOSE4_PS(r4, r5, r6, r7);
+    Float first[4] = {r0, r1, r2, r3};
+    Float second[4] = {r4, r5, r6, r7};
+    for (int k = 0; k < count; ++k) {
+      _mm_storeu_ps(fishPers[k].worldPosition, first[k]);
+      _mm_storeu_ps(fishPers[k].nextPosition, second[k]);
+    }
+  }
+};
+
+}  // namespace
+
+void updateFishSSE4(const FishConstants &constants,
+                    const FishParams &params,
+                    int begin,
+                    int end,
+                    FishPer *fishPers) {
+  fishkernel::updateFish<SimdSSE4>(constants, params, begin, end, fishPers);
+}
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FrameTimeRecorder.cpp: Implement the recorder of frame times.
+
+#include "FrameTimeRecorder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// The smallest value that percentile percent of sorted values don't exceed.
+// The rank is rounded down a little, so that the error of percentile, like
+// 99.9, doesn't push it to the next value.
+double getPercentile(const std::vector<double> &sorted, double percentile) {
+  size_t rank = static_cast<size_t>(std::ceil(
+      percentile * static_cast<double>(sorted.size()) / 100.0 - 1e-6));
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+}  // namespace
+
+void FrameTimeRecorder::addFrame(
+    std::chrono::steady_clock::duration frameTime) {
+  mFrameTimes.push_back(
+      std::chrono::duration<double, std::milli>(frameTime).count());
+}
+
+FrameTimeStats FrameTimeRecorder::computeStats() const {
+  FrameTimeStats stats = FrameTimeStats();
+  stats.frameCount = mFrameTimes.size();
+  if (mFrameTimes.empty()) {
+    return stats;
+  }
+
+  std::vector<double> sorted(mFrameTimes);
+  std::sort(sorted.begin(), sorted.end());
+
+  size_t count = sorted.size();
+  for (double frameTime : sorted) {
+    stats.totalTime += frameTime;
+  }
+  stats.mean = stats.totalTime / count;
+  stats.median = count % 2 == 1
+                     ? sorted[count / 2]
+                     : (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0;
+  stats.p90 = getPercentile(sorted, 90.0);
+  stats.p99 = getPercentile(sorted, 99.0);
+  stats.p999 = getPercentile(sorted, 99.9);
+  stats.min = sorted.front();
+  stats.max = sorted.back();
+
+  double variance = 0.0;
+  for (double frameTime : sorted) {
+    variance += (frameTime - stats.mean) * (frameTime - stats.mean);
+  }
+  stats.stddev = std::sqrt(variance / count);
+  stats.averageFps = stats.totalTime > 0.0 ? 1000.0 * count / stats.totalTime
+                                           : 0.0;
+
+  stats.stutterThreshold = stats.median * kStutterFactor;
+  stats.stutterCount = static_cast<int>(
+      sorted.end() - std::upper_bound(sorted.begin(), sorted.end(),
+                                      stats.stutterThreshold));
+
+  return stats;
+}
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FrameTimeRecorder.h: Define the recorder of frame times in benchmark mode.
+// Every frame time is kept, so that tail latency can be computed besides the
+// average.
+
+#ifndef FRAMETIMERECORDER_H
+#define FRAMETIMERECORDER_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Statistics of recorded frames. Times are in milliseconds, and percentiles
+// are nearest rank.
+struct FrameTimeStats {
+  size_t frameCount;
+  double totalTime;
+  double mean;
+  double median;
+  double p90;
+  double p99;
+  double p999;
+  double min;
+  double max;
+  double stddev;
+  double averageFps;
+  // Frames taking longer than stutterThreshold.
+  int stutterCount;
+  double stutterThreshold;
+};
+
+class FrameTimeRecorder {
+public:
+  // A frame is a stutter if it takes longer than kStutterFactor times the
+  // median.
+  static constexpr double kStutterFactor = 2.0;
+
+  void reset() { mFrameTimes.clear(); }
+  void addFrame(std::chrono::steady_clock::duration frameTime);
+
+  size_t getFrameCount() const { return mFrameTimes.size(); }
+  const std::vector<double> &getFrameTimes() const { return mFrameTimes; }
+  FrameTimeStats computeStats() const;
+
+private:
+  std::vector<double> mFrameTimes;
+};
+
+#endif  // FRAMETIMERECORDER_H
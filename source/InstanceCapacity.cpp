@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// InstanceCapacity.cpp: Implement the capacity policy of per instance
+// resources.
+
+#include "InstanceCapacity.h"
+
+#include <algorithm>
+
+constexpr int InstanceCapacity::kMinCapacity;
+
+InstanceCapacity::InstanceCapacity() : mCapacity(0), mUnderusedFrames(0) {}
+
+bool InstanceCapacity::grow(int count) {
+  mUnderusedFrames = 0;
+  if (count <= mCapacity) {
+    return false;
+  }
+
+  int capacity = std::max(mCapacity, kMinCapacity);
+  while (capacity < count) {
+    capacity *= 2;
+  }
+  mCapacity = capacity;
+  return true;
+}
+
+bool InstanceCapacity::shrink(int count) {
+  if (mCapacity <= kMinCapacity || count > mCapacity / 4) {
+    mUnderusedFrames = 0;
+    return false;
+  }
+
+  if (++mUnderusedFrames < kShrinkDelay) {
+    return false;
+  }
+
+  // Leave room to double before growing again.
+  mUnderusedFrames = 0;
+  int capacity = std::max(count * 2, kMinCapacity);
+  if (capacity >= mCapacity) {
+    return false;
+  }
+  mCapacity = capacity;
+  return true;
+}
@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// InstanceCapacity.h: Define the capacity policy of per instance resources.
+// Capacity grows geometrically, so that ramping up the instance count costs
+// amortized O(1) reallocations per instance. It shrinks only after the count
+// has stayed under a quarter of it for kShrinkDelay frames, so that counts
+// going up and down around a boundary don't reallocate every time.
+
+#ifndef INSTANCECAPACITY_H
+#define INSTANCECAPACITY_H
+
+class InstanceCapacity {
+public:
+  static constexpr int kMinCapacity = 64;
+  static constexpr int kShrinkDelay = 300;
+
+  InstanceCapacity();
+
+  // Return true if the capacity has to grow to hold count instances.
+  bool grow(int count);
+  // Call it once per frame. Return true if the capacity shrinks to follow a
+  // count that has stayed small.
+  bool shrink(int count);
+
+  int getCapacity() const { return mCapacity; }
+
+private:
+  int mCapacity;
+  int mUnderusedFrames;
+};
+
+#endif  // INSTANCECAPACITY_H
@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// JobSystem.cpp: Implement the work-stealing job system.
+
+#include "JobSystem.h"
+
+#include "Assert.h"
+
+JobSystem::JobSystem(int threadCount)
+    : mFunc(nullptr), mGeneration(0), mPendingJobs(0), mExit(false) {
+  if (threadCount <= 0) {
+    threadCount = getDefaultThreadCount();
+  }
+
+  for (int i = 0; i < threadCount; ++i) {
+    mQueues.emplace_back(new JobQueue());
+  }
+  for (int i = 1; i < threadCount; ++i) {
+    mWorkers.emplace_back(&JobSystem::workerLoop, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mExit = true;
+  }
+  mWakeCondition.notify_all();
+
+  for (auto &worker : mWorkers) {
+    worker.join();
+  }
+}
+
+int JobSystem::getDefaultThreadCount() {
+  unsigned int cores = std::thread::hardware_concurrency();
+  return cores == 0 ? 1 : static_cast<int>(cores);
+}
+
+void JobSystem::parallelFor(int count, const std::function<void(int)> &func) {
+  if (count <= 0) {
+    return;
+  }
+
+  if (mWorkers.empty() || count == 1) {
+    for (int i = 0; i < count; ++i) {
+      func(i);
+    }
+    return;
+  }
+
+  ASSERT(mPendingJobs == 0);
+  mPendingJobs = count;
+
+  // Hand out contiguous ranges of jobs so that neighbouring jobs tend to run
+  // on the same thread.
+  int queueCount = getThreadCount();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFunc = &func;
+    for (int q = 0; q < queueCount; ++q) {
+      std::lock_guard<std::mutex> queueLock(mQueues[q]->mutex);
+      for (int i = count * q / queueCount; i < count * (q + 1) / queueCount;
+           ++i) {
+        mQueues[q]->jobs.push_back(i);
+      }
+    }
+    ++mGeneration;
+  }
+  mWakeCondition.notify_all();
+
+  runJobs(0);
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mDoneCondition.wait(lock, [this] { return mPendingJobs == 0; });
+  mFunc = nullptr;
+}
+
+// Pop a job from the back of the own queue, or steal one from the front of
+// another queue.
+bool JobSystem::popJob(int queueIndex, int *job) {
+  {
+    JobQueue &queue = *mQueues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.jobs.empty()) {
+      *job = queue.jobs.back();
+      queue.jobs.pop_back();
+      return true;
+    }
+  }
+
+  int queueCount = getThreadCount();
+  for (int i = 1; i < queueCount; ++i) {
+    JobQueue &victim = *mQueues[(queueIndex + i) % queueCount];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      *job = victim.jobs.front();
+      victim.jobs.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void JobSystem::runJobs(int queueIndex) {
+  int job;
+  while (popJob(queueIndex, &job)) {
+    // mFunc is published before the jobs are queued, and stays valid until
+    // the last job is done.
+    (*mFunc)(job);
+    if (mPendingJobs.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mDoneCondition.notify_all();
+    }
+  }
+}
+
+void JobSystem::workerLoop(int queueIndex) {
+  unsigned int generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWakeCondition.wait(
+          lock, [&] { return mExit || mGeneration != generation; });
+      if (mExit) {
+        return;
+      }
+      generation = mGeneration;
+    }
+
+    runJobs(queueIndex);
+  }
+}
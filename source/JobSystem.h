@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// JobSystem.h: Define a work-stealing job system. Each thread owns a job
+// queue, and steals jobs from the other queues once its own is empty.
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem {
+public:
+  // threadCount includes the calling thread, so threadCount - 1 workers are
+  // created. 0 means one thread per core.
+  explicit JobSystem(int threadCount);
+  ~JobSystem();
+
+  static int getDefaultThreadCount();
+  int getThreadCount() const { return static_cast<int>(mQueues.size()); }
+
+  // Run func(0) to func(count - 1) on all threads and return once all of
+  // them are done. The calling thread runs jobs as well.
+  void parallelFor(int count, const std::function<void(int)> &func);
+
+private:
+  struct JobQueue {
+    std::mutex mutex;
+    std::deque<int> jobs;
+  };
+
+  bool popJob(int queueIndex, int *job);
+  void runJobs(int queueIndex);
+  void workerLoop(int queueIndex);
+
+  // Queue 0 belongs to the calling thread of parallelFor.
+  std::vector<std::unique_ptr<JobQueue>> mQueues;
+  std::vector<std::thread> mWorkers;
+
+  std::mutex mMutex;
+  std::condition_variable mWakeCondition;
+  std::condition_variable mDoneCondition;
+  const std::function<void(int)> *mFunc;
+  unsigned int mGeneration;
+  std::atomic<int> mPendingJobs;
+  bool mExit;
+};
+
+#endif  // JOBSYSTEM_H
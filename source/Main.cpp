@@ -13,7 +13,5 @@ int main(int argc, char **argv) {
     return -1;
   }
 
-  aquarium.display();
-
-  return 0;
+  return aquarium.display() ? 0 : -1;
 }
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// MappedFile.cpp: Implement the read only file mapping by mmap or
+// MapViewOfFile.
+
+#include "MappedFile.h"
+
+#include <cstdio>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(OS_WIN)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+bool getFileInfo(const std::string &path, uint64_t *size, int64_t *time) {
+#if defined(OS_WIN)
+  struct _stat64 st;
+  if (_stat64(path.c_str(), &st) != 0) {
+    return false;
+  }
+#else
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return false;
+  }
+#endif
+  *size = static_cast<uint64_t>(st.st_size);
+  *time = static_cast<int64_t>(st.st_mtime);
+  return true;
+}
+
+bool replaceFile(const std::string &tempPath, const std::string &path) {
+  std::remove(path.c_str());
+  if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+MappedFile::MappedFile()
+    : mData(nullptr),
+      mSize(0)
+#if defined(OS_WIN)
+      ,
+      mFile(INVALID_HANDLE_VALUE),
+      mMapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const std::string &path) {
+  close();
+
+#if defined(OS_WIN)
+  mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0) {
+    close();
+    return false;
+  }
+  mMapping =
+      CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mMapping == nullptr) {
+    close();
+    return false;
+  }
+  mData = static_cast<const char *>(
+      MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+  if (mData == nullptr) {
+    close();
+    return false;
+  }
+  mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  mData = static_cast<const char *>(data);
+  mSize = static_cast<size_t>(st.st_size);
+#endif
+
+  return true;
+}
+
+void MappedFile::close() {
+#if defined(OS_WIN)
+  if (mData != nullptr) {
+    UnmapViewOfFile(mData);
+  }
+  if (mMapping != nullptr) {
+    CloseHandle(mMapping);
+    mMapping = nullptr;
+  }
+  if (mFile != INVALID_HANDLE_VALUE) {
+    CloseHandle(mFile);
+    mFile = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (mData != nullptr) {
+    munmap(const_cast<char *>(mData), mSize);
+  }
+#endif
+  mData = nullptr;
+  mSize = 0;
+}
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// MappedFile.h: Define a read only file mapping, and helpers shared by the
+// binary asset caches.
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "build/build_config.h"
+
+// Get the size and modification time of a file, which caches record to tell
+// if they are stale.
+bool getFileInfo(const std::string &path, uint64_t *size, int64_t *time);
+// Replace path by a completely written tempPath, so that a partially written
+// cache is never picked up.
+bool replaceFile(const std::string &tempPath, const std::string &path);
+
+class MappedFile {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Map the whole file. Return false if it's missing or empty.
+  bool open(const std::string &path);
+  void close();
+
+  const char *getData() const { return mData; }
+  size_t getSize() const { return mSize; }
+
+private:
+  const char *mData;
+  size_t mSize;
+#if defined(OS_WIN)
+  void *mFile;
+  void *mMapping;
+#endif
+};
+
+#endif  // MAPPEDFILE_H
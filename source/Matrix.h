@@ -5,11 +5,30 @@
 //
 // Matrix.h: Do matrix calculations including multiply, addition, substraction,
 // transpose, inverse, translation, etc.
+//
+// mulMatrixMatrix4, mulMatrixMatrix4Batch and transpose4 have float overloads
+// that use SSE on x86 and NEON on arm64. They do the same multiplies and adds
+// in the same order as the templates and never fuse them, so results are
+// identical to the templates, 0 ulp, unless the compiler contracts the
+// templates into fused multiply-add. In that case each element differs by at
+// most 2 ulp of the sum of the absolute values of its four products. Call the
+// templates with an explicit <float> to get the scalar path.
 
 #ifndef MATRIX_H
 #define MATRIX_H
 
 #include <cmath>
+#include <cstddef>
+
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <xmmintrin.h>
+#define MATRIX_SIMD_SSE
+#elif defined(ARCH_CPU_ARM64) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MATRIX_SIMD_NEON
+#endif
 
 namespace matrix {
 static long long RANDOM_RANGE_ = 4294967296;
@@ -66,6 +85,101 @@ void mulMatrixMatrix4(T *dst, const T *a, const T *b) {
   dst[15] = a30 * b03 + a31 * b13 + a32 * b23 + a33 * b33;
 }
 
+// Multiply count matrices of a by b, dst[i] = a[i] * b. Matrices are stored
+// contiguously, 16 elements each.
+template <typename T>
+void mulMatrixMatrix4Batch(T *dst, const T *a, const T *b, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    mulMatrixMatrix4(dst + i * 16, a + i * 16, b);
+  }
+}
+
+#if defined(MATRIX_SIMD_SSE) || defined(MATRIX_SIMD_NEON)
+namespace simd {
+
+#if defined(MATRIX_SIMD_SSE)
+typedef __m128 Row;
+inline Row load(const float *p) {
+  return _mm_loadu_ps(p);
+}
+inline void store(float *p, Row r) {
+  _mm_storeu_ps(p, r);
+}
+inline Row splat(float f) {
+  return _mm_set1_ps(f);
+}
+inline Row mul(Row a, Row b) {
+  return _mm_mul_ps(a, b);
+}
+inline Row add(Row a, Row b) {
+  return _mm_add_ps(a, b);
+}
+#else
+typedef float32x4_t Row;
+inline Row load(const float *p) {
+  return vld1q_f32(p);
+}
+inline void store(float *p, Row r) {
+  vst1q_f32(p, r);
+}
+inline Row splat(float f) {
+  return vdupq_n_f32(f);
+}
+inline Row mul(Row a, Row b) {
+  return vmulq_f32(a, b);
+}
+inline Row add(Row a, Row b) {
+  return vaddq_f32(a, b);
+}
+#endif
+
+// dst = a * b, b is passed as its four rows. Row i of dst is the sum of the
+// rows of b weighted by row i of a, accumulated in the order of the template.
+inline void mulMatrixRows4(float *dst,
+                           const float *a,
+                           Row b0,
+                           Row b1,
+                           Row b2,
+                           Row b3) {
+  Row r0 = add(add(add(mul(splat(a[0]), b0), mul(splat(a[1]), b1)),
+                   mul(splat(a[2]), b2)),
+               mul(splat(a[3]), b3));
+  Row r1 = add(add(add(mul(splat(a[4]), b0), mul(splat(a[5]), b1)),
+                   mul(splat(a[6]), b2)),
+               mul(splat(a[7]), b3));
+  Row r2 = add(add(add(mul(splat(a[8]), b0), mul(splat(a[9]), b1)),
+                   mul(splat(a[10]), b2)),
+               mul(splat(a[11]), b3));
+  Row r3 = add(add(add(mul(splat(a[12]), b0), mul(splat(a[13]), b1)),
+                   mul(splat(a[14]), b2)),
+               mul(splat(a[15]), b3));
+  store(dst, r0);
+  store(dst + 4, r1);
+  store(dst + 8, r2);
+  store(dst + 12, r3);
+}
+
+}  // namespace simd
+
+inline void mulMatrixMatrix4(float *dst, const float *a, const float *b) {
+  simd::mulMatrixRows4(dst, a, simd::load(b), simd::load(b + 4),
+                       simd::load(b + 8), simd::load(b + 12));
+}
+
+inline void mulMatrixMatrix4Batch(float *dst,
+                                  const float *a,
+                                  const float *b,
+                                  size_t count) {
+  simd::Row b0 = simd::load(b);
+  simd::Row b1 = simd::load(b + 4);
+  simd::Row b2 = simd::load(b + 8);
+  simd::Row b3 = simd::load(b + 12);
+  for (size_t i = 0; i < count; ++i) {
+    simd::mulMatrixRows4(dst + i * 16, a + i * 16, b0, b1, b2, b3);
+  }
+}
+#endif
+
 template <typename T>
 void inverse4(T *dst, const T *m) {
   T m00 = m[0 * 4 + 0];
@@ -187,6 +301,29 @@ void transpose4(T *dst, const T *m) {
   dst[15] = m33;
 }
 
+#if defined(MATRIX_SIMD_SSE)
+inline void transpose4(float *dst, const float *m) {
+  __m128 r0 = _mm_loadu_ps(m);
+  __m128 r1 = _mm_loadu_ps(m + 4);
+  __m128 r2 = _mm_loadu_ps(m + 8);
+  __m128 r3 = _mm_loadu_ps(m + 12);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(dst, r0);
+  _mm_storeu_ps(dst + 4, r1);
+  _mm_storeu_ps(dst + 8, r2);
+  _mm_storeu_ps(dst + 12, r3);
+}
+#elif defined(MATRIX_SIMD_NEON)
+inline void transpose4(float *dst, const float *m) {
+  // De-interleaving load gathers the columns of m.
+  float32x4x4_t columns = vld4q_f32(m);
+  vst1q_f32(dst, columns.val[0]);
+  vst1q_f32(dst + 4, columns.val[1]);
+  vst1q_f32(dst + 8, columns.val[2]);
+  vst1q_f32(dst + 12, columns.val[3]);
+}
+#endif
+
 template <typename T>
 void frustum(T *dst, T left, T right, T bottom, T top, T near_, T far_) {
   T dx = right - left;
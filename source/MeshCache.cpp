@@ -0,0 +1,275 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// MeshCache.cpp: Implement the binary mesh cache.
+
+#include "MeshCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "rapidjson/document.h"
+#include "rapidjson/istreamwrapper.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'Q', 'M', 'C'};
+constexpr size_t kDataAlignment = 16;
+
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t sourceSize;
+  int64_t sourceTime;
+  uint32_t textureCount;
+  uint32_t fieldCount;
+};
+
+struct FileTexture {
+  char name[64];
+  char image[64];
+};
+
+struct FileField {
+  char name[32];
+  int32_t numComponents;
+  uint32_t isIndex;
+  int32_t totalComponents;
+  uint32_t padding;
+  uint64_t offset;
+};
+
+size_t alignData(size_t offset) {
+  return (offset + kDataAlignment - 1) & ~(kDataAlignment - 1);
+}
+
+size_t getFieldByteSize(const MeshField &field) {
+  return field.totalComponents *
+         (field.isIndex ? sizeof(unsigned short) : sizeof(float));
+}
+
+// Copy a string to a fixed size record, return false if it doesn't fit.
+template <size_t N>
+bool copyName(char (&dst)[N], const std::string &src) {
+  if (src.size() >= N) {
+    return false;
+  }
+  memset(dst, 0, N);
+  memcpy(dst, src.c_str(), src.size());
+  return true;
+}
+
+template <size_t N>
+std::string readName(const char (&src)[N]) {
+  return std::string(src, strnlen(src, N));
+}
+
+}  // namespace
+
+bool MeshCache::load(const std::string &cachePath,
+                     const std::string &sourcePath) {
+  mFile.close();
+  mTextures.clear();
+  mFields.clear();
+
+  uint64_t sourceSize;
+  int64_t sourceTime;
+  if (!getFileInfo(sourcePath, &sourceSize, &sourceTime) ||
+      !mFile.open(cachePath)) {
+    return false;
+  }
+  const char *mappedData = mFile.getData();
+  size_t mappedSize = mFile.getSize();
+  if (mappedSize < sizeof(FileHeader)) {
+    mFile.close();
+    return false;
+  }
+
+  const FileHeader *header = reinterpret_cast<const FileHeader *>(mappedData);
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kVersion || header->sourceSize != sourceSize ||
+      header->sourceTime != sourceTime) {
+    mFile.close();
+    return false;
+  }
+
+  size_t tableEnd = sizeof(FileHeader) +
+                    header->textureCount * sizeof(FileTexture) +
+                    header->fieldCount * sizeof(FileField);
+  if (tableEnd > mappedSize) {
+    mFile.close();
+    return false;
+  }
+
+  const FileTexture *textures =
+      reinterpret_cast<const FileTexture *>(mappedData + sizeof(FileHeader));
+  for (uint32_t i = 0; i < header->textureCount; ++i) {
+    MeshTexture texture;
+    texture.name = readName(textures[i].name);
+    texture.image = readName(textures[i].image);
+    mTextures.push_back(texture);
+  }
+
+  const FileField *fields = reinterpret_cast<const FileField *>(
+      textures + header->textureCount);
+  for (uint32_t i = 0; i < header->fieldCount; ++i) {
+    MeshField field;
+    field.name = readName(fields[i].name);
+    field.numComponents = fields[i].numComponents;
+    field.isIndex = fields[i].isIndex != 0;
+    field.totalComponents = fields[i].totalComponents;
+    field.data = mappedData + fields[i].offset;
+    if (field.numComponents <= 0 || field.totalComponents < 0 ||
+        fields[i].offset % kDataAlignment != 0 ||
+        fields[i].offset < tableEnd ||
+        fields[i].offset + getFieldByteSize(field) > mappedSize) {
+      mTextures.clear();
+      mFields.clear();
+      mFile.close();
+      return false;
+    }
+    mFields.push_back(field);
+  }
+
+  return true;
+}
+
+bool MeshCache::loadJson(const std::string &sourcePath) {
+  mFile.close();
+  mTextures.clear();
+  mFields.clear();
+  mFloatData.clear();
+  mIndexData.clear();
+
+  std::ifstream modelStream(sourcePath, std::ios::in);
+  if (!modelStream) {
+    std::cerr << "Failed to open " << sourcePath << std::endl;
+    return false;
+  }
+  rapidjson::IStreamWrapper is(modelStream);
+  rapidjson::Document document;
+  document.ParseStream(is);
+  if (!document.IsObject() || !document.HasMember("models") ||
+      !document["models"].IsArray() || document["models"].Empty()) {
+    std::cerr << "Failed to parse " << sourcePath << std::endl;
+    return false;
+  }
+
+  const rapidjson::Value &models = document["models"];
+  const rapidjson::Value &value = models[models.Size() - 1];
+
+  const rapidjson::Value &textures = value["textures"];
+  for (rapidjson::Value::ConstMemberIterator itr = textures.MemberBegin();
+       itr != textures.MemberEnd(); ++itr) {
+    MeshTexture texture;
+    texture.name = itr->name.GetString();
+    texture.image = itr->value.GetString();
+    mTextures.push_back(texture);
+  }
+
+  const rapidjson::Value &arrays = value["fields"];
+  for (rapidjson::Value::ConstMemberIterator itr = arrays.MemberBegin();
+       itr != arrays.MemberEnd(); ++itr) {
+    MeshField field;
+    field.name = itr->name.GetString();
+    field.numComponents = itr->value["numComponents"].GetInt();
+    field.isIndex = field.name == "indices";
+    field.data = nullptr;
+
+    const rapidjson::Value &data = itr->value["data"];
+    field.totalComponents = static_cast<int>(data.Size());
+    if (field.isIndex) {
+      std::vector<unsigned short> vec;
+      vec.reserve(data.Size());
+      for (auto &element : data.GetArray()) {
+        vec.push_back(element.GetInt());
+      }
+      mIndexData.push_back(std::move(vec));
+    } else {
+      std::vector<float> vec;
+      vec.reserve(data.Size());
+      for (auto &element : data.GetArray()) {
+        vec.push_back(element.GetFloat());
+      }
+      mFloatData.push_back(std::move(vec));
+    }
+    mFields.push_back(field);
+  }
+
+  // Point fields to their data once all of the arrays are in place.
+  size_t floatIndex = 0;
+  size_t indexIndex = 0;
+  for (MeshField &field : mFields) {
+    if (field.isIndex) {
+      field.data = mIndexData[indexIndex++].data();
+    } else {
+      field.data = mFloatData[floatIndex++].data();
+    }
+  }
+
+  return true;
+}
+
+bool MeshCache::write(const std::string &cachePath,
+                      const std::string &sourcePath) const {
+  FileHeader header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  if (!getFileInfo(sourcePath, &header.sourceSize, &header.sourceTime)) {
+    return false;
+  }
+  header.textureCount = static_cast<uint32_t>(mTextures.size());
+  header.fieldCount = static_cast<uint32_t>(mFields.size());
+
+  std::vector<FileTexture> textures(mTextures.size());
+  for (size_t i = 0; i < mTextures.size(); ++i) {
+    if (!copyName(textures[i].name, mTextures[i].name) ||
+        !copyName(textures[i].image, mTextures[i].image)) {
+      return false;
+    }
+  }
+
+  size_t offset = sizeof(FileHeader) + textures.size() * sizeof(FileTexture) +
+                  mFields.size() * sizeof(FileField);
+  std::vector<FileField> fields(mFields.size());
+  for (size_t i = 0; i < mFields.size(); ++i) {
+    if (!copyName(fields[i].name, mFields[i].name)) {
+      return false;
+    }
+    fields[i].numComponents = mFields[i].numComponents;
+    fields[i].isIndex = mFields[i].isIndex ? 1 : 0;
+    fields[i].totalComponents = mFields[i].totalComponents;
+    fields[i].padding = 0;
+    offset = alignData(offset);
+    fields[i].offset = offset;
+    offset += getFieldByteSize(mFields[i]);
+  }
+
+  std::string tempPath = cachePath + ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary);
+    if (!stream) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char *>(textures.data()),
+                 textures.size() * sizeof(FileTexture));
+    stream.write(reinterpret_cast<const char *>(fields.data()),
+                 fields.size() * sizeof(FileField));
+    const char zeros[kDataAlignment] = {};
+    for (size_t i = 0; i < mFields.size(); ++i) {
+      size_t position = static_cast<size_t>(stream.tellp());
+      stream.write(zeros, fields[i].offset - position);
+      stream.write(static_cast<const char *>(mFields[i].data),
+                   getFieldByteSize(mFields[i]));
+    }
+    if (!stream) {
+      return false;
+    }
+  }
+
+  return replaceFile(tempPath, cachePath);
+}
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// MeshCache.h: Define the binary mesh cache. A model is parsed from its json
+// file once and written to a binary container, which later runs map into
+// memory and read without parsing or copying.
+//
+// The container holds a header, the texture table, the field table and the
+// field data, each field aligned to 16 bytes. It records the size and
+// modification time of the json file, and is considered stale if either of
+// them changes or its version doesn't match kVersion.
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+struct MeshTexture {
+  std::string name;
+  std::string image;
+};
+
+struct MeshField {
+  std::string name;
+  int numComponents;
+  bool isIndex;
+  // Points to totalComponents floats, or unsigned shorts for indices.
+  const void *data;
+  int totalComponents;
+};
+
+class MeshCache {
+public:
+  // Bump it whenever the layout of the container changes.
+  static constexpr uint32_t kVersion = 1;
+
+  // Map the cache file. Return false if it's missing, corrupted or stale.
+  bool load(const std::string &cachePath, const std::string &sourcePath);
+  // Parse the last model of the json file.
+  bool loadJson(const std::string &sourcePath);
+  // Write the loaded mesh to the cache file.
+  bool write(const std::string &cachePath,
+             const std::string &sourcePath) const;
+
+  const std::vector<MeshTexture> &getTextures() const { return mTextures; }
+  const std::vector<MeshField> &getFields() const { return mFields; }
+
+private:
+  std::vector<MeshTexture> mTextures;
+  std::vector<MeshField> mFields;
+
+  // Field data parsed from json.
+  std::vector<std::vector<float>> mFloatData;
+  std::vector<std::vector<unsigned short>> mIndexData;
+
+  MappedFile mFile;
+};
+
+#endif  // MESHCACHE_H
@@ -19,6 +19,18 @@ Model::~Model() {
   }
 }
 
+void Model::updateInstanceUniforms(const Mat4 *worlds,
+                                   const Mat4 *worldInverseTransposes,
+                                   const Mat4 *worldViewProjections,
+                                   size_t count) {
+  WorldUniforms worldUniforms;
+  for (size_t i = 0; i < count; ++i) {
+    copyWorldUniforms(worlds[i], worldInverseTransposes[i],
+                      worldViewProjections[i], &worldUniforms);
+    updatePerInstanceUniforms(worldUniforms);
+  }
+}
+
 void Model::setProgram(Program *prgm) {
   mProgram = prgm;
 }
@@ -11,9 +11,11 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <cstring>
 #include <string>
 #include <vector>
 
+#include "AlignedAllocator.h"
 #include "Aquarium.h"
 
 class Buffer;
@@ -24,6 +26,25 @@ struct WorldUniforms;
 enum MODELGROUP : short;
 enum MODELNAME : short;
 
+// A 4x4 matrix aligned to a cache line.
+struct alignas(64) Mat4 {
+  float m[16];
+};
+
+typedef std::vector<Mat4, AlignedAllocator<Mat4, alignof(Mat4)>> Mat4Array;
+
+// Copy the transforms of an instance to its uniforms.
+inline void copyWorldUniforms(const Mat4 &world,
+                              const Mat4 &worldInverseTranspose,
+                              const Mat4 &worldViewProjection,
+                              WorldUniforms *worldUniforms) {
+  memcpy(worldUniforms->world, world.m, sizeof(worldUniforms->world));
+  memcpy(worldUniforms->worldInverseTranspose, worldInverseTranspose.m,
+         sizeof(worldUniforms->worldInverseTranspose));
+  memcpy(worldUniforms->worldViewProjection, worldViewProjection.m,
+         sizeof(worldUniforms->worldViewProjection));
+}
+
 class Model {
 public:
   Model(MODELGROUP type, MODELNAME name, bool blend)
@@ -32,12 +53,25 @@ public:
   virtual void prepareForDraw() = 0;
   virtual void updatePerInstanceUniforms(
       const WorldUniforms &worldUniforms) = 0;
+  // Update uniforms of instances [0, count) from the transform arrays.
+  // Models that draw all of their instances at once copy them straight to
+  // their own uniform storage. By default each instance is passed to
+  // updatePerInstanceUniforms.
+  virtual void updateInstanceUniforms(const Mat4 *worlds,
+                                      const Mat4 *worldInverseTransposes,
+                                      const Mat4 *worldViewProjections,
+                                      size_t count);
   virtual void draw() = 0;
 
   void setProgram(Program *program);
   virtual void init() = 0;
 
-  std::vector<std::vector<float>> worldmatrices;
+  // Transforms of instances are stored contiguously. Placements never change,
+  // so inverse transposes are computed once at load time, while world view
+  // projections are recomputed each frame.
+  Mat4Array worldmatrices;
+  Mat4Array worldInverseTransposes;
+  Mat4Array worldViewProjections;
   std::unordered_map<std::string, Texture *> textureMap;
   std::unordered_map<std::string, Buffer *> bufferMap;
 
@@ -6,9 +6,12 @@
 
 #include "ResourceHelper.h"
 
+#include <cerrno>
 #include <iostream>
 #include <sstream>
 
+#include <sys/stat.h>
+
 #include "Assert.h"
 #include "build/build_config.h"
 
@@ -28,6 +31,7 @@ const std::string slash = "/";
 
 static const char *shaderFolder = "shaders";
 static const char *resourceFolder = "assets";
+static const char *cacheFolder = "cache";
 
 const std::vector<std::string> skyBoxUrls = {
     "GlobeOuter_EM_positive_x.jpg", "GlobeOuter_EM_negative_x.jpg",
@@ -77,6 +81,10 @@ ResourceHelper::ResourceHelper(const std::string &mBackendName,
                 << mShaderVersion << slash;
   mProgramPath = programStream.str();
 
+  std::ostringstream cacheStream;
+  cacheStream << mPath << cacheFolder << slash;
+  mCachePath = cacheStream.str();
+
   std::ostringstream fishBehaviorStream;
   fishBehaviorStream << mPath << "FishBehavior.json";
   mFishBehaviorPath = fishBehaviorStream.str();
@@ -100,6 +108,8 @@ ResourceHelper::ResourceHelper(const std::string &mBackendName,
         mBackendTypeStr += "OpenGL";
       else if (1 << expo == BACKENDTYPE::BACKENDTYPEVULKAN)
         mBackendTypeStr += "Vulkan";
+      else if (1 << expo == BACKENDTYPE::BACKENDTYPENULL)
+        mBackendTypeStr += "Null";
     }
   }
 }
@@ -119,6 +129,35 @@ std::string ResourceHelper::getModelPath(const std::string &modelName) const {
   return modelStream.str();
 }
 
+bool ResourceHelper::createCacheFolder() const {
+  std::string path = mCachePath.substr(0, mCachePath.size() - slash.size());
+#if defined(OS_WIN)
+  int result = _mkdir(path.c_str());
+#else
+  int result = mkdir(path.c_str(), 0755);
+#endif
+  if (result != 0 && errno != EEXIST) {
+    std::cerr << "Failed to create cache folder " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::string ResourceHelper::getMeshCachePath(
+    const std::string &modelName) const {
+  std::ostringstream meshCacheStream;
+  meshCacheStream << mCachePath << modelName << ".mesh";
+  return meshCacheStream.str();
+}
+
+std::string ResourceHelper::getTextureCachePath(
+    const std::string &textureName) const {
+  std::ostringstream textureCacheStream;
+  textureCacheStream << mCachePath << textureName << "." << mBackendName
+                     << ".tex";
+  return textureCacheStream.str();
+}
+
 const std::string &ResourceHelper::getProgramPath() const {
   return mProgramPath;
 }
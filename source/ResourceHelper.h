@@ -21,6 +21,14 @@ public:
   const std::string &getPropPlacementPath() const { return mPropPlacementPath; }
   const std::string &getImagePath() const { return mImagePath; }
   std::string getModelPath(const std::string &modelName) const;
+  // Caches of converted assets are kept in the cache folder, which is created
+  // on first use. Return false if it can't be created.
+  const std::string &getCachePath() const { return mCachePath; }
+  bool createCacheFolder() const;
+  std::string getMeshCachePath(const std::string &modelName) const;
+  // Backends lay out texture images differently, so each of them has its own
+  // texture cache.
+  std::string getTextureCachePath(const std::string &textureName) const;
   const std::string &getProgramPath() const;
   const std::string &getFishBehaviorPath() const { return mFishBehaviorPath; }
   const std::string &getBackendName() const { return mBackendName; }
@@ -35,6 +43,7 @@ private:
   std::string mProgramPath;
   std::string mPropPlacementPath;
   std::string mModelPath;
+  std::string mCachePath;
   std::string mFishBehaviorPath;
 
   std::string mBackendName;
@@ -8,28 +8,109 @@
 #include "Texture.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "Assert.h"
+#include "Trace.h"
 #include "stb_image.h"
 #include "stb_image_resize.h"
 
 Texture::Texture(const std::string &name, const std::string &url, bool flip)
-    : mUrls(), mWidth(0), mHeight(0), mFlip(flip), mName(name) {
+    : mUrls(),
+      mWidth(0),
+      mHeight(0),
+      mFlip(flip),
+      mPrepared(false),
+      mName(name) {
   std::string urlpath = url;
   mUrls.push_back(urlpath);
 }
 
+Texture::~Texture() {
+  releaseImages();
+}
+
+void Texture::prepareTexture() {
+  TRACE_SCOPE("decodeTexture");
+  mPrepared = true;
+  if (!mCachePath.empty() &&
+      mCache.load(mCachePath, mUrls,
+                  [this](int width, int height,
+                         std::vector<size_t> *imageSizes) {
+                    getImageSizes(width, height, imageSizes);
+                  })) {
+    mWidth = mCache.getWidth();
+    mHeight = mCache.getHeight();
+    mImageVec = mCache.getImages();
+    mImageSizes = mCache.getImageSizes();
+    return;
+  }
+
+  if (!loadImage(mUrls, &mPixelVec)) {
+    return;
+  }
+  processImages();
+
+  if (!mCachePath.empty() &&
+      !TextureCache::write(mCachePath, mUrls, mWidth, mHeight, mImageVec,
+                           mImageSizes)) {
+    std::cerr << "Failed to write texture cache " << mCachePath << std::endl;
+  }
+}
+
+void Texture::processImages() {
+  for (uint8_t *pixels : mPixelVec) {
+    addImage(pixels, static_cast<size_t>(mWidth) * mHeight * 4);
+  }
+}
+
+void Texture::getImageSizes(int width,
+                            int height,
+                            std::vector<size_t> *imageSizes) const {
+  imageSizes->assign(mUrls.size(), static_cast<size_t>(width) * height * 4);
+}
+
+void Texture::getMipImageSizes(int width,
+                               int height,
+                               bool padRows,
+                               std::vector<size_t> *imageSizes) {
+  int mipLevelCount =
+      static_cast<int>(floor(log2(std::max(width, height)))) + 1;
+  imageSizes->resize(mipLevelCount);
+  for (int i = 0; i < mipLevelCount; ++i) {
+    int levelWidth = padRows ? width : std::max(width >> i, 1);
+    int levelHeight = std::max(height >> i, 1);
+    (*imageSizes)[i] = static_cast<size_t>(levelWidth) * levelHeight * 4;
+  }
+}
+
+void Texture::addImage(const uint8_t *image, size_t size) {
+  mImageVec.push_back(image);
+  mImageSizes.push_back(size);
+}
+
+void Texture::releaseImages() {
+  mImageVec.clear();
+  mImageSizes.clear();
+  mCache.close();
+  DestoryImageData(mPixelVec);
+  mPixelVec.clear();
+  DestoryImageData(mResizedVec);
+  mResizedVec.clear();
+}
+
 // Force loading 3 channel images to 4 channel by stb becasue Dawn doesn't
 // support 3 channel formats currently. The group is discussing on whether
 // webgpu shoud support 3 channel format.
 // https://github.com/gpuweb/gpuweb/issues/66#issuecomment-410021505
+// Images are flipped here rather than by stbi_set_flip_vertically_on_load(),
+// which is a global setting and races when textures are decoded in parallel.
 bool Texture::loadImage(const std::vector<std::string> &urls,
                         std::vector<uint8_t *> *pixels) {
-  stbi_set_flip_vertically_on_load(mFlip);
   for (auto filename : urls) {
     uint8_t *pixel = stbi_load(filename.c_str(), &mWidth, &mHeight, 0, 4);
     if (pixel == 0) {
@@ -37,11 +118,26 @@ bool Texture::loadImage(const std::vector<std::string> &urls,
                 << std::endl;
       return false;
     }
+    if (mFlip) {
+      flipImage(pixel, mWidth, mHeight);
+    }
     pixels->push_back(pixel);
   }
   return true;
 }
 
+void Texture::flipImage(uint8_t *pixels, int width, int height) {
+  size_t rowSize = static_cast<size_t>(width) * 4;
+  std::vector<uint8_t> row(rowSize);
+  for (int top = 0, bottom = height - 1; top < bottom; ++top, --bottom) {
+    uint8_t *topRow = pixels + top * rowSize;
+    uint8_t *bottomRow = pixels + bottom * rowSize;
+    memcpy(row.data(), topRow, rowSize);
+    memcpy(topRow, bottomRow, rowSize);
+    memcpy(bottomRow, row.data(), rowSize);
+  }
+}
+
 bool Texture::isPowerOf2(int value) {
   return (value & (value - 1)) == 0;
 }
@@ -97,6 +193,9 @@ void Texture::generateMipmap(uint8_t *input_pixels,
       if (height == 0) {
         height = 1;
       }
+      if (width == 0) {
+        width = 1;
+      }
     }
   } else {
     uint8_t *pixels =
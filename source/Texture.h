@@ -11,15 +11,31 @@
 #include <string>
 #include <vector>
 
+#include "TextureCache.h"
+
 class Texture {
 public:
-  virtual ~Texture() {}
+  virtual ~Texture();
   Texture(const std::string &name,
           const std::vector<std::string> &urls,
           bool flip)
-      : mUrls(urls), mFlip(flip), mName(name) {}
+      : mUrls(urls),
+        mWidth(0),
+        mHeight(0),
+        mFlip(flip),
+        mPrepared(false),
+        mName(name) {}
   Texture(const std::string &name, const std::string &url, bool flip);
   std::string getName() { return mName; }
+  // Keep the images to upload in the texture cache at path. Textures aren't
+  // cached if it's not set.
+  void setCachePath(const std::string &path) { mCachePath = path; }
+  // Map the images to upload from the texture cache, or decode them, do the
+  // rest of the cpu work of loading and refresh the cache. It doesn't touch
+  // the graphics api, so textures can be prepared on worker threads.
+  void prepareTexture();
+  // Upload the texture to gpu. It prepares the texture first if that's not
+  // done yet.
   virtual void loadTexture() = 0;
   void generateMipmap(uint8_t *input_pixels,
                       int input_w,
@@ -33,9 +49,29 @@ public:
                       bool is256padding);
 
 protected:
-  bool isPowerOf2(int);
+  // Build the images to upload from the decoded images by addImage(). The
+  // decoded images are uploaded as is by default.
+  virtual void processImages();
+  // Get the sizes of the images processImages() builds for a texture of
+  // width x height pixels, which the texture cache is checked against. It's
+  // one image of width x height pixels per url by default.
+  virtual void getImageSizes(int width,
+                             int height,
+                             std::vector<size_t> *imageSizes) const;
+  // Get the sizes of the full mip chain of a texture of width x height
+  // pixels, as built by generateMipmap(). Rows of every level are width
+  // pixels long if padRows is set.
+  static void getMipImageSizes(int width,
+                               int height,
+                               bool padRows,
+                               std::vector<size_t> *imageSizes);
+  void addImage(const uint8_t *image, size_t size);
+  // Free decoded images and unmap the texture cache once they are uploaded.
+  void releaseImages();
+  static bool isPowerOf2(int value);
   bool loadImage(const std::vector<std::string> &urls,
                  std::vector<uint8_t *> *pixels);
+  void flipImage(uint8_t *pixels, int width, int height);
   void DestoryImageData(std::vector<uint8_t *> &pixelVec);
   void copyPaddingBuffer(unsigned char *dst,
                          unsigned char *src,
@@ -44,11 +80,20 @@ protected:
                          int kPadding);
 
   std::vector<std::string> mUrls;
+  std::vector<uint8_t *> mPixelVec;
+  std::vector<uint8_t *> mResizedVec;
+  // Images uploaded by loadTexture(), which are cube faces or mip levels.
+  // They point to mPixelVec, mResizedVec or the mapped texture cache.
+  std::vector<const uint8_t *> mImageVec;
+  std::vector<size_t> mImageSizes;
   int mWidth;
   int mHeight;
   bool mFlip;
+  bool mPrepared;
 
   std::string mName;
+  std::string mCachePath;
+  TextureCache mCache;
 };
 
 #endif  // TEXTURE_H
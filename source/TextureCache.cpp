@@ -0,0 +1,182 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TextureCache.cpp: Implement the binary texture cache.
+
+#include "TextureCache.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr char kMagic[4] = {'A', 'Q', 'T', 'C'};
+constexpr size_t kDataAlignment = 16;
+
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  uint32_t sourceCount;
+  uint32_t imageCount;
+};
+
+struct FileSource {
+  uint64_t size;
+  int64_t time;
+};
+
+struct FileImage {
+  uint64_t offset;
+  uint64_t size;
+};
+
+size_t alignData(size_t offset) {
+  return (offset + kDataAlignment - 1) & ~(kDataAlignment - 1);
+}
+
+bool getSources(const std::vector<std::string> &sourcePaths,
+                std::vector<FileSource> *sources) {
+  sources->resize(sourcePaths.size());
+  for (size_t i = 0; i < sourcePaths.size(); ++i) {
+    if (!getFileInfo(sourcePaths[i], &(*sources)[i].size,
+                     &(*sources)[i].time)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TextureCache::TextureCache() : mWidth(0), mHeight(0) {}
+
+bool TextureCache::load(const std::string &cachePath,
+                        const std::vector<std::string> &sourcePaths,
+                        const ImageSizesFunc &getImageSizes) {
+  close();
+
+  std::vector<FileSource> sources;
+  if (!getSources(sourcePaths, &sources) || !mFile.open(cachePath)) {
+    return false;
+  }
+  const char *mappedData = mFile.getData();
+  size_t mappedSize = mFile.getSize();
+  if (mappedSize < sizeof(FileHeader)) {
+    close();
+    return false;
+  }
+
+  const FileHeader *header = reinterpret_cast<const FileHeader *>(mappedData);
+  size_t tableEnd = sizeof(FileHeader) +
+                    header->sourceCount * sizeof(FileSource) +
+                    header->imageCount * sizeof(FileImage);
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kVersion || header->width <= 0 ||
+      header->height <= 0 || header->sourceCount != sources.size() ||
+      tableEnd > mappedSize) {
+    close();
+    return false;
+  }
+
+  const FileSource *fileSources =
+      reinterpret_cast<const FileSource *>(mappedData + sizeof(FileHeader));
+  for (size_t i = 0; i < sources.size(); ++i) {
+    if (fileSources[i].size != sources[i].size ||
+        fileSources[i].time != sources[i].time) {
+      close();
+      return false;
+    }
+  }
+
+  std::vector<size_t> imageSizes;
+  getImageSizes(header->width, header->height, &imageSizes);
+  if (header->imageCount != imageSizes.size()) {
+    close();
+    return false;
+  }
+
+  const FileImage *images = reinterpret_cast<const FileImage *>(
+      fileSources + header->sourceCount);
+  for (uint32_t i = 0; i < header->imageCount; ++i) {
+    if (images[i].size != imageSizes[i] ||
+        images[i].offset % kDataAlignment != 0 ||
+        images[i].offset < tableEnd || images[i].offset > mappedSize ||
+        images[i].size > mappedSize - images[i].offset) {
+      close();
+      return false;
+    }
+    mImages.push_back(
+        reinterpret_cast<const uint8_t *>(mappedData + images[i].offset));
+    mImageSizes.push_back(static_cast<size_t>(images[i].size));
+  }
+
+  mWidth = header->width;
+  mHeight = header->height;
+  return true;
+}
+
+void TextureCache::close() {
+  mWidth = 0;
+  mHeight = 0;
+  mImages.clear();
+  mImageSizes.clear();
+  mFile.close();
+}
+
+bool TextureCache::write(const std::string &cachePath,
+                         const std::vector<std::string> &sourcePaths,
+                         int width,
+                         int height,
+                         const std::vector<const uint8_t *> &images,
+                         const std::vector<size_t> &imageSizes) {
+  FileHeader header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.width = width;
+  header.height = height;
+  header.sourceCount = static_cast<uint32_t>(sourcePaths.size());
+  header.imageCount = static_cast<uint32_t>(images.size());
+
+  std::vector<FileSource> sources;
+  if (!getSources(sourcePaths, &sources)) {
+    return false;
+  }
+
+  size_t offset = sizeof(FileHeader) + sources.size() * sizeof(FileSource) +
+                  images.size() * sizeof(FileImage);
+  std::vector<FileImage> fileImages(images.size());
+  for (size_t i = 0; i < images.size(); ++i) {
+    offset = alignData(offset);
+    fileImages[i].offset = offset;
+    fileImages[i].size = imageSizes[i];
+    offset += imageSizes[i];
+  }
+
+  std::string tempPath = cachePath + ".tmp";
+  {
+    std::ofstream stream(tempPath, std::ios::out | std::ios::binary);
+    if (!stream) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char *>(sources.data()),
+                 sources.size() * sizeof(FileSource));
+    stream.write(reinterpret_cast<const char *>(fileImages.data()),
+                 fileImages.size() * sizeof(FileImage));
+    const char zeros[kDataAlignment] = {};
+    for (size_t i = 0; i < images.size(); ++i) {
+      size_t position = static_cast<size_t>(stream.tellp());
+      stream.write(zeros, fileImages[i].offset - position);
+      stream.write(reinterpret_cast<const char *>(images[i]), imageSizes[i]);
+    }
+    if (!stream) {
+      return false;
+    }
+  }
+
+  return replaceFile(tempPath, cachePath);
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TextureCache.h: Define the binary texture cache. The images a backend
+// uploads for a texture, which are decoded RGBA8 cube faces or mip levels in
+// the row layout of the backend, are written to a container once, and later
+// runs map them into memory and upload them without decoding or resizing.
+//
+// The container holds a header, the source table, the image table and the
+// image data, each image aligned to 16 bytes. It records the size and
+// modification time of every source image, and is considered stale if any of
+// them changes or its version doesn't match kVersion.
+
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+class TextureCache {
+public:
+  // Bump it whenever the layout of the container, or the way any backend
+  // lays out its images, changes.
+  static constexpr uint32_t kVersion = 1;
+
+  // Get the sizes of the images a backend uploads for a texture of width x
+  // height pixels, one per cube face or mip level.
+  using ImageSizesFunc = std::function<
+      void(int width, int height, std::vector<size_t> *imageSizes)>;
+
+  TextureCache();
+
+  // Map the cache file. Return false if it's missing, corrupted or stale, or
+  // if its images don't match the count and sizes getImageSizes expects.
+  bool load(const std::string &cachePath,
+            const std::vector<std::string> &sourcePaths,
+            const ImageSizesFunc &getImageSizes);
+  // Unmap the cache file, images are invalid afterwards.
+  void close();
+  // Write images of a texture of width x height pixels to the cache file.
+  static bool write(const std::string &cachePath,
+                    const std::vector<std::string> &sourcePaths,
+                    int width,
+                    int height,
+                    const std::vector<const uint8_t *> &images,
+                    const std::vector<size_t> &imageSizes);
+
+  int getWidth() const { return mWidth; }
+  int getHeight() const { return mHeight; }
+  const std::vector<const uint8_t *> &getImages() const { return mImages; }
+  const std::vector<size_t> &getImageSizes() const { return mImageSizes; }
+
+private:
+  int mWidth;
+  int mHeight;
+  std::vector<const uint8_t *> mImages;
+  std::vector<size_t> mImageSizes;
+
+  MappedFile mFile;
+};
+
+#endif  // TEXTURECACHE_H
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Trace.cpp: Implement scoped trace events.
+
+#include "Trace.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rapidjson/ostreamwrapper.h"
+#include "rapidjson/writer.h"
+
+namespace {
+
+struct TraceEvent {
+  const char *name;
+  std::chrono::steady_clock::time_point begin;
+  std::chrono::steady_clock::time_point end;
+};
+
+// Events of a thread. The lock is only contended while the trace is written.
+struct ThreadEvents {
+  std::mutex mutex;
+  std::vector<TraceEvent> events;
+};
+
+std::atomic<bool> gEnabled(false);
+std::mutex gMutex;
+std::string gPath;
+std::chrono::steady_clock::time_point gStart;
+// Indexed by tid. The thread starting the trace is tid 0.
+std::vector<std::unique_ptr<ThreadEvents>> gThreads;
+
+thread_local ThreadEvents *tThreadEvents = nullptr;
+
+ThreadEvents *getThreadEvents() {
+  if (tThreadEvents == nullptr) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gThreads.emplace_back(new ThreadEvents());
+    tThreadEvents = gThreads.back().get();
+  }
+  return tThreadEvents;
+}
+
+double toMicroseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+}  // namespace
+
+void Tracer::start(const std::string &path) {
+  gPath = path;
+  gStart = std::chrono::steady_clock::now();
+  getThreadEvents();
+  gEnabled = true;
+}
+
+bool Tracer::isEnabled() {
+  return gEnabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::addEvent(const char *name,
+                      std::chrono::steady_clock::time_point begin,
+                      std::chrono::steady_clock::time_point end) {
+  ThreadEvents *threadEvents = getThreadEvents();
+  std::lock_guard<std::mutex> lock(threadEvents->mutex);
+  threadEvents->events.push_back({name, begin, end});
+}
+
+bool Tracer::stop() {
+  if (!gEnabled) {
+    return true;
+  }
+  gEnabled = false;
+
+  std::ofstream stream(gPath, std::ios::out | std::ios::trunc);
+  if (!stream) {
+    std::cerr << "Failed to open " << gPath << std::endl;
+    return false;
+  }
+
+  rapidjson::OStreamWrapper streamWrapper(stream);
+  rapidjson::Writer<rapidjson::OStreamWrapper> writer(streamWrapper);
+  writer.StartObject();
+  writer.Key("displayTimeUnit");
+  writer.String("ms");
+  writer.Key("traceEvents");
+  writer.StartArray();
+
+  std::lock_guard<std::mutex> lock(gMutex);
+  for (size_t tid = 0; tid < gThreads.size(); ++tid) {
+    std::string threadName =
+        tid == 0 ? "main" : "worker " + std::to_string(tid);
+    writer.StartObject();
+    writer.Key("name");
+    writer.String("thread_name");
+    writer.Key("ph");
+    writer.String("M");
+    writer.Key("pid");
+    writer.Int(0);
+    writer.Key("tid");
+    writer.Uint(static_cast<unsigned>(tid));
+    writer.Key("args");
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(threadName.c_str());
+    writer.EndObject();
+    writer.EndObject();
+
+    std::lock_guard<std::mutex> threadLock(gThreads[tid]->mutex);
+    for (const TraceEvent &event : gThreads[tid]->events) {
+      writer.StartObject();
+      writer.Key("name");
+      writer.String(event.name);
+      writer.Key("cat");
+      writer.String("aquarium");
+      writer.Key("ph");
+      writer.String("X");
+      writer.Key("ts");
+      writer.Double(toMicroseconds(event.begin - gStart));
+      writer.Key("dur");
+      writer.Double(toMicroseconds(event.end - event.begin));
+      writer.Key("pid");
+      writer.Int(0);
+      writer.Key("tid");
+      writer.Uint(static_cast<unsigned>(tid));
+      writer.EndObject();
+    }
+    gThreads[tid]->events.clear();
+  }
+
+  writer.EndArray();
+  writer.EndObject();
+  stream << std::endl;
+
+  if (!stream) {
+    std::cerr << "Failed to write " << gPath << std::endl;
+    return false;
+  }
+  std::cout << "Trace is written to " << gPath << std::endl;
+  return true;
+}
+
+ScopedTrace::ScopedTrace(const char *name)
+    : mName(name), mEnabled(Tracer::isEnabled()) {
+  if (mEnabled) {
+    mBegin = std::chrono::steady_clock::now();
+  }
+}
+
+ScopedTrace::~ScopedTrace() {
+  if (mEnabled) {
+    Tracer::addEvent(mName, mBegin, std::chrono::steady_clock::now());
+  }
+}
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// Trace.h: Define scoped trace events written as Chrome trace event json,
+// which can be opened in chrome://tracing or Perfetto. Each thread records to
+// its own buffer, and the buffers are merged when the trace is written.
+//
+// TRACE_SCOPE(name) records the scope it is put in. It compiles to nothing
+// unless ENABLE_TRACE is defined, and costs a flag check if no trace is
+// started. name must be a string literal.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <string>
+
+class Tracer {
+public:
+  // Start recording events, which are written to path by stop().
+  static void start(const std::string &path);
+  static bool isEnabled();
+  static void addEvent(const char *name,
+                       std::chrono::steady_clock::time_point begin,
+                       std::chrono::steady_clock::time_point end);
+  // Stop recording and write the events. Other threads must not record any
+  // more events by then.
+  static bool stop();
+};
+
+class ScopedTrace {
+public:
+  explicit ScopedTrace(const char *name);
+  ~ScopedTrace();
+
+private:
+  const char *mName;
+  bool mEnabled;
+  std::chrono::steady_clock::time_point mBegin;
+};
+
+#if defined(ENABLE_TRACE)
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) \
+  ScopedTrace TRACE_CONCAT(scopedTrace, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+#endif  // TRACE_H
@@ -11,7 +11,7 @@
 BufferD3D12::BufferD3D12(ContextD3D12 *context,
                          int totalCmoponents,
                          int numComponents,
-                         const std::vector<float> &buffer,
+                         const float *buffer,
                          bool isIndex)
     : mIsIndex(isIndex),
       mTotoalComponents(totalCmoponents),
@@ -19,7 +19,7 @@ BufferD3D12::BufferD3D12(ContextD3D12 *context,
       mOffset(nullptr) {
   mSize = totalCmoponents * sizeof(float);
   mBuffer =
-      context->createDefaultBuffer(buffer.data(), mSize, mSize, mUploadBuffer);
+      context->createDefaultBuffer(buffer, mSize, mSize, mUploadBuffer);
 
   // Initialize the vertex buffer view.
   mVertexBufferView.BufferLocation = mBuffer->GetGPUVirtualAddress();
@@ -30,7 +30,7 @@ BufferD3D12::BufferD3D12(ContextD3D12 *context,
 BufferD3D12::BufferD3D12(ContextD3D12 *context,
                          int totalCmoponents,
                          int numComponents,
-                         const std::vector<unsigned short> &buffer,
+                         const unsigned short *buffer,
                          bool isIndex)
     : mIsIndex(isIndex),
       mTotoalComponents(totalCmoponents),
@@ -38,7 +38,7 @@ BufferD3D12::BufferD3D12(ContextD3D12 *context,
       mOffset(nullptr) {
   mSize = totalCmoponents * sizeof(unsigned short);
   mBuffer =
-      context->createDefaultBuffer(buffer.data(), mSize, mSize, mUploadBuffer);
+      context->createDefaultBuffer(buffer, mSize, mSize, mUploadBuffer);
 
   // Initialize the vertex buffer view.
   mIndexBufferView.BufferLocation = mBuffer->GetGPUVirtualAddress();
@@ -13,6 +13,7 @@
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 
+#include "../Trace.h"
 #include "BufferD3D12.h"
 #include "FishModelD3D12.h"
 #include "FishModelInstancedDrawD3D12.h"
@@ -393,6 +394,7 @@ void ContextD3D12::initAvailableToggleBitset(BACKENDTYPE backendType) {
 
 void ContextD3D12::DoFlush(
     const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset) {
+  TRACE_SCOPE("DoFlush");
   if (mDisableD3D12RenderPass) {
     // Resolve MSAA texture to non MSAA texture, and then present.
     if (mMSAASampleCount > 1) {
@@ -447,9 +449,15 @@ void ContextD3D12::DoFlush(
   }
 
   // Present the frame.
-  ThrowIfFailed(mSwapChain->Present(mVsync, 0));
+  {
+    TRACE_SCOPE("present");
+    ThrowIfFailed(mSwapChain->Present(mVsync, 0));
+  }
 
-  WaitForPreviousFrame();
+  {
+    TRACE_SCOPE("waitForPreviousFrame");
+    WaitForPreviousFrame();
+  }
 
   glfwPollEvents();
 }
@@ -607,18 +615,20 @@ Model *ContextD3D12::createModel(Aquarium *aquarium,
 }
 
 Buffer *ContextD3D12::createBuffer(int numComponents,
-                                   std::vector<float> *buf,
+                                   const float *buf,
+                                   int totalComponents,
                                    bool isIndex) {
-  Buffer *buffer = new BufferD3D12(this, static_cast<int>(buf->size()),
-                                   numComponents, *buf, isIndex);
+  Buffer *buffer =
+      new BufferD3D12(this, totalComponents, numComponents, buf, isIndex);
   return buffer;
 }
 
 Buffer *ContextD3D12::createBuffer(int numComponents,
-                                   std::vector<unsigned short> *buf,
+                                   const unsigned short *buf,
+                                   int totalComponents,
                                    bool isIndex) {
-  Buffer *buffer = new BufferD3D12(this, static_cast<int>(buf->size()),
-                                   numComponents, *buf, isIndex);
+  Buffer *buffer =
+      new BufferD3D12(this, totalComponents, numComponents, buf, isIndex);
   return buffer;
 }
 
@@ -631,16 +641,12 @@ Program *ContextD3D12::createProgram(const std::string &mVId,
 
 Texture *ContextD3D12::createTexture(const std::string &name,
                                      const std::string &url) {
-  Texture *texture = new TextureD3D12(this, name, url);
-  texture->loadTexture();
-  return texture;
+  return new TextureD3D12(this, name, url);
 }
 
 Texture *ContextD3D12::createTexture(const std::string &name,
                                      const std::vector<std::string> &urls) {
-  Texture *texture = new TextureD3D12(this, name, urls);
-  texture->loadTexture();
-  return texture;
+  return new TextureD3D12(this, name, urls);
 }
 
 void ContextD3D12::initGeneralResources(Aquarium *aquarium) {
@@ -711,7 +717,9 @@ void ContextD3D12::initGeneralResources(Aquarium *aquarium) {
       CalcConstantBufferByteSize(sizeof(FishPer) * aquarium->getCurFishCount()),
       stagingBuffer);
   mFishPersBufferView.BufferLocation = mFishPersBuffer->GetGPUVirtualAddress();
-  mFishPersBufferView.SizeInBytes = CalcConstantBufferByteSize(sizeof(FishPer));
+  mFishPersBufferView.SizeInBytes =
+      CalcConstantBufferByteSize(sizeof(FishPer) * aquarium->getCurFishCount());
+  mFishPersBufferView.StrideInBytes = sizeof(FishPer);
 
   mPreTotalInstance = aquarium->getPreFishCount();
   mCurTotalInstance = aquarium->getCurFishCount();
@@ -1082,7 +1090,7 @@ void ContextD3D12::createRootSignature(
 }
 
 void ContextD3D12::createTexture(const D3D12_RESOURCE_DESC &textureDesc,
-                                 const std::vector<UINT8 *> &texture,
+                                 const std::vector<const UINT8 *> &texture,
                                  ComPtr<ID3D12Resource> &m_texture,
                                  ComPtr<ID3D12Resource> &textureUploadHeap,
                                  int TextureWidth,
@@ -1266,7 +1274,9 @@ void ContextD3D12::reallocResource(int preTotalInstance,
       CalcConstantBufferByteSize(sizeof(FishPer) * curTotalInstance),
       stagingBuffer);
   mFishPersBufferView.BufferLocation = mFishPersBuffer->GetGPUVirtualAddress();
-  mFishPersBufferView.SizeInBytes = CalcConstantBufferByteSize(sizeof(FishPer));
+  mFishPersBufferView.SizeInBytes =
+      CalcConstantBufferByteSize(sizeof(FishPer) * curTotalInstance);
+  mFishPersBufferView.StrideInBytes = sizeof(FishPer);
 }
 
 void ContextD3D12::destoryFishResource() {
@@ -52,10 +52,12 @@ public:
                      MODELNAME name,
                      bool blend) override;
   Buffer *createBuffer(int numComponents,
-                       std::vector<float> *buffer,
+                       const float *buffer,
+                       int totalComponents,
                        bool isIndex) override;
   Buffer *createBuffer(int numComponents,
-                       std::vector<unsigned short> *buffer,
+                       const unsigned short *buffer,
+                       int totalComponents,
                        bool isIndex) override;
 
   Program *createProgram(const std::string &mVId,
@@ -110,7 +112,7 @@ public:
                           D3D12_GPU_DESCRIPTOR_HANDLE *hGpuDescriptor);
   UINT CalcConstantBufferByteSize(UINT byteSize);
   void createTexture(const D3D12_RESOURCE_DESC &textureDesc,
-                     const std::vector<UINT8 *> &texture,
+                     const std::vector<const UINT8 *> &texture,
                      ComPtr<ID3D12Resource> &m_texture,
                      ComPtr<ID3D12Resource> &textureUploadHeap,
                      int TextureWidth,
@@ -146,7 +148,7 @@ public:
 
   std::vector<CD3DX12_STATIC_SAMPLER_DESC> staticSamplers;
 
-  D3D12_CONSTANT_BUFFER_VIEW_DESC mFishPersBufferView;
+  D3D12_VERTEX_BUFFER_VIEW mFishPersBufferView;
   ComPtr<ID3D12Resource> mFishPersBuffer;
   ComPtr<ID3D12Resource> stagingBuffer;
   FishPer *fishPers;
@@ -65,6 +65,14 @@ void FishModelD3D12::init() {
        D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
       {"TEXCOORD", 4, DXGI_FORMAT_R32G32B32_FLOAT, 4, 0,
        D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+      {"TEXCOORD", 5, DXGI_FORMAT_R32G32B32_FLOAT, 5, 0,
+       D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+      {"TEXCOORD", 6, DXGI_FORMAT_R32_FLOAT, 5, 3 * sizeof(float),
+       D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+      {"TEXCOORD", 7, DXGI_FORMAT_R32G32B32_FLOAT, 5, 4 * sizeof(float),
+       D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+      {"TEXCOORD", 8, DXGI_FORMAT_R32_FLOAT, 5, 7 * sizeof(float),
+       D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
   };
 
   // create constant buffer, desc.
@@ -89,9 +97,9 @@ void FishModelD3D12::init() {
 
   // Create root signature to bind resources.
   // Bind textures, samplers and immutable constant buffers in a descriptor
-  // table. Bind frequently updated constant buffers by root descriptors.
+  // table. Per fish data is read from the vertex buffer of FishPer.
   CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-  CD3DX12_ROOT_PARAMETER1 rootParameters[5];
+  CD3DX12_ROOT_PARAMETER1 rootParameters[4];
   CD3DX12_DESCRIPTOR_RANGE1 ranges[2];
   rootParameters[0] = mContextD3D12->rootParameterGeneral;
   rootParameters[1] = mContextD3D12->rootParameterWorld;
@@ -123,10 +131,6 @@ void FishModelD3D12::init() {
                                             D3D12_SHADER_VISIBILITY_PIXEL);
   }
 
-  rootParameters[4].InitAsConstantBufferView(
-      0, 3, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE,
-      D3D12_SHADER_VISIBILITY_VERTEX);
-
   rootSignatureDesc.Init_1_1(
       _countof(rootParameters), rootParameters, 2u,
       mContextD3D12->staticSamplers.data(),
@@ -157,17 +161,16 @@ void FishModelD3D12::draw() {
 
   mContextD3D12->mCommandList->IASetPrimitiveTopology(
       D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-  mContextD3D12->mCommandList->IASetVertexBuffers(0, 5, mVertexBufferView);
+  // The fish pers buffer is reallocated when the fish count grows.
+  mVertexBufferView[5] = mContextD3D12->mFishPersBufferView;
+  mContextD3D12->mCommandList->IASetVertexBuffers(0, 6, mVertexBufferView);
   mContextD3D12->mCommandList->IASetIndexBuffer(
       &mIndicesBuffer->mIndexBufferView);
 
+  // The first instance of each draw picks the FishPer of the fish.
   for (int i = 0; i < mCurInstance; i++) {
-    mContextD3D12->mCommandList->SetGraphicsRootConstantBufferView(
-        4, mContextD3D12->mFishPersBufferView.BufferLocation +
-               (mFishPerOffset + i) *
-                   mContextD3D12->mFishPersBufferView.SizeInBytes);
     mContextD3D12->mCommandList->DrawIndexedInstanced(
-        mIndicesBuffer->getTotalComponents(), 1, 0, 0, 0);
+        mIndicesBuffer->getTotalComponents(), 1, 0, 0, mFishPerOffset + i);
   }
 }
 
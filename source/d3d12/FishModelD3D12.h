@@ -38,6 +38,9 @@ public:
                              float scale,
                              float time,
                              int index) override;
+  FishPer *getFishPers() override {
+    return mContextD3D12->fishPers + mFishPerOffset;
+  }
 
   struct FishVertexUniforms {
     float fishLength;
@@ -76,7 +79,7 @@ private:
 
   std::vector<D3D12_INPUT_ELEMENT_DESC> mInputElementDescs;
 
-  D3D12_VERTEX_BUFFER_VIEW mVertexBufferView[5];
+  D3D12_VERTEX_BUFFER_VIEW mVertexBufferView[6];
 
   ComPtr<ID3D12RootSignature> mRootSignature;
 
@@ -195,3 +195,17 @@ void GenericModelD3D12::updatePerInstanceUniforms(
 
   mInstance++;
 }
+
+void GenericModelD3D12::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    copyWorldUniforms(worlds[i], worldInverseTransposes[i],
+                      worldViewProjections[i],
+                      &mWorldUniformPer.WorldUniforms[i]);
+  }
+
+  mInstance = static_cast<int>(count);
+}
@@ -143,3 +143,15 @@ void InnerModelD3D12::updatePerInstanceUniforms(
     const WorldUniforms &worldUniforms) {
   memcpy(&mWorldUniformPer, &worldUniforms, sizeof(WorldUniforms));
 }
+
+void InnerModelD3D12::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  // The inner tank is drawn once.
+  if (count > 0) {
+    copyWorldUniforms(worlds[0], worldInverseTransposes[0],
+                      worldViewProjections[0], &mWorldUniformPer);
+  }
+}
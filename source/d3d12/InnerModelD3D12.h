@@ -26,6 +26,10 @@ public:
   void prepareForDraw() override;
   void draw() override;
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void updateInstanceUniforms(const Mat4 *worlds,
+                              const Mat4 *worldInverseTransposes,
+                              const Mat4 *worldViewProjections,
+                              size_t count) override;
 
   struct InnerUniforms {
     float eta;
@@ -158,5 +158,21 @@ void SeaweedModelD3D12::updatePerInstanceUniforms(
   instance++;
 }
 
+void SeaweedModelD3D12::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    copyWorldUniforms(worlds[i], worldInverseTransposes[i],
+                      worldViewProjections[i],
+                      &mWorldUniformPer.worldUniforms[i]);
+    mSeaweedPer.seaweed[i].time =
+        mAquarium->g.mclock + static_cast<float>(i);
+  }
+
+  instance = static_cast<int>(count);
+}
+
 void SeaweedModelD3D12::updateSeaweedModelTime(float time) {
 }
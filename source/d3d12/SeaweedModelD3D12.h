@@ -27,6 +27,10 @@ public:
   void draw() override;
 
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void updateInstanceUniforms(const Mat4 *worlds,
+                              const Mat4 *worldInverseTransposes,
+                              const Mat4 *worldViewProjections,
+                              size_t count) override;
 
   TextureD3D12 *mDiffuseTexture;
   TextureD3D12 *mNormalTexture;
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cmath>
 
+#include "../Assert.h"
 #include "ContextD3D12.h"
 
 TextureD3D12::~TextureD3D12() {
@@ -36,8 +37,37 @@ TextureD3D12::TextureD3D12(ContextD3D12 *context,
       mContext(context) {
 }
 
+void TextureD3D12::processImages() {
+  if (mTextureViewDimension == D3D12_SRV_DIMENSION_TEXTURECUBE) {
+    Texture::processImages();
+    return;
+  }
+
+  generateMipmap(mPixelVec[0], mWidth, mHeight, 0, mResizedVec, mWidth,
+                 mHeight, 0, 4, false);
+  std::vector<size_t> imageSizes;
+  getImageSizes(mWidth, mHeight, &imageSizes);
+  ASSERT(imageSizes.size() == mResizedVec.size());
+  for (size_t i = 0; i < mResizedVec.size(); ++i) {
+    addImage(mResizedVec[i], imageSizes[i]);
+  }
+}
+
+void TextureD3D12::getImageSizes(int width,
+                                 int height,
+                                 std::vector<size_t> *imageSizes) const {
+  if (mTextureViewDimension == D3D12_SRV_DIMENSION_TEXTURECUBE) {
+    Texture::getImageSizes(width, height, imageSizes);
+    return;
+  }
+
+  getMipImageSizes(width, height, false, imageSizes);
+}
+
 void TextureD3D12::loadTexture() {
-  loadImage(mUrls, &mPixelVec);
+  if (!mPrepared) {
+    prepareTexture();
+  }
 
   if (mTextureViewDimension == D3D12_SRV_DIMENSION_TEXTURECUBE) {
     D3D12_RESOURCE_DESC textureDesc = {};
@@ -52,12 +82,9 @@ void TextureD3D12::loadTexture() {
     textureDesc.Dimension = mTextureDimension;
 
     mContext->createTexture(
-        textureDesc, mPixelVec, mTexture, mTextureUploadHeap, mWidth, mHeight,
+        textureDesc, mImageVec, mTexture, mTextureUploadHeap, mWidth, mHeight,
         4u, textureDesc.MipLevels, textureDesc.DepthOrArraySize);
   } else {
-    generateMipmap(mPixelVec[0], mWidth, mHeight, 0, mResizedVec, mWidth,
-                   mHeight, 0, 4, false);
-
     D3D12_RESOURCE_DESC textureDesc = {};
     textureDesc.MipLevels = static_cast<uint16_t>(std::floor(
                                 std::log2(std::max(mWidth, mHeight)))) +
@@ -72,9 +99,12 @@ void TextureD3D12::loadTexture() {
     textureDesc.Dimension = mTextureDimension;
 
     mContext->createTexture(
-        textureDesc, mResizedVec, mTexture, mTextureUploadHeap, mWidth, mHeight,
+        textureDesc, mImageVec, mTexture, mTextureUploadHeap, mWidth, mHeight,
         4u, textureDesc.MipLevels, textureDesc.DepthOrArraySize);
   }
+
+  // Images are copied to the upload heap already.
+  releaseImages();
 }
 
 // Allocate descriptors sequentially on deascriptor heap to bind root signature,
@@ -39,6 +39,11 @@ public:
   void createSrvDescriptor();
 
 private:
+  void processImages() override;
+  void getImageSizes(int width,
+                     int height,
+                     std::vector<size_t> *imageSizes) const override;
+
   D3D12_RESOURCE_DIMENSION mTextureDimension;
   D3D12_SRV_DIMENSION mTextureViewDimension;
   DXGI_FORMAT mFormat;
@@ -47,8 +52,6 @@ private:
   D3D12_SHADER_RESOURCE_VIEW_DESC mSrvDesc;
   D3D12_GPU_DESCRIPTOR_HANDLE mTextureGPUHandle;
 
-  std::vector<unsigned char *> mPixelVec;
-  std::vector<unsigned char *> mResizedVec;
   ContextD3D12 *mContext;
 };
 
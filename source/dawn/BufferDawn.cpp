@@ -14,7 +14,7 @@
 BufferDawn::BufferDawn(ContextDawn *context,
                        int totalCmoponents,
                        int numComponents,
-                       std::vector<float> *buffer,
+                       const float *buffer,
                        bool isIndex)
     : mUsage(isIndex ? wgpu::BufferUsage::Index : wgpu::BufferUsage::Vertex),
       mTotoalComponents(totalCmoponents),
@@ -24,20 +24,20 @@ BufferDawn::BufferDawn(ContextDawn *context,
 
   // Create buffer for vertex buffer. Because float is multiple of 4 bytes,
   // dummy padding isnt' needed.
-  int bufferSize = sizeof(float) * static_cast<int>(buffer->size());
+  int bufferSize = sizeof(float) * mTotoalComponents;
   wgpu::BufferDescriptor descriptor;
   descriptor.usage = mUsage | wgpu::BufferUsage::CopyDst;
   descriptor.size = bufferSize;
   descriptor.mappedAtCreation = false;
   mBuf = context->createBuffer(descriptor);
 
-  context->setBufferData(mBuf, bufferSize, buffer->data(), bufferSize);
+  context->setBufferData(mBuf, bufferSize, buffer, bufferSize);
 }
 
 BufferDawn::BufferDawn(ContextDawn *context,
                        int totalCmoponents,
                        int numComponents,
-                       std::vector<unsigned short> *buffer,
+                       const unsigned short *buffer,
                        bool isIndex)
     : mUsage(isIndex ? wgpu::BufferUsage::Index : wgpu::BufferUsage::Vertex),
       mTotoalComponents(totalCmoponents),
@@ -46,19 +46,17 @@ BufferDawn::BufferDawn(ContextDawn *context,
   mSize = numComponents * sizeof(unsigned short);
   // Create buffer for index buffer. Because unsigned short is multiple of 2
   // bytes, in order to align with 4 bytes of dawn metal, dummy padding need to
-  // be added.
-  if (mTotoalComponents % 2 != 0) {
-    buffer->push_back(0.0f);
-  }
-
-  int bufferSize = sizeof(unsigned short) * static_cast<int>(buffer->size());
+  // be added. The staging buffer is zero initialized, so only the data is
+  // copied.
+  int dataSize = sizeof(unsigned short) * mTotoalComponents;
+  int bufferSize = (dataSize + 3) & ~3;
   wgpu::BufferDescriptor descriptor;
   descriptor.usage = mUsage | wgpu::BufferUsage::CopyDst;
   descriptor.size = bufferSize;
   descriptor.mappedAtCreation = false;
   mBuf = context->createBuffer(descriptor);
 
-  context->setBufferData(mBuf, bufferSize, buffer->data(), bufferSize);
+  context->setBufferData(mBuf, bufferSize, buffer, dataSize);
 }
 
 BufferDawn::~BufferDawn() {
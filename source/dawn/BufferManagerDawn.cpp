@@ -5,8 +5,10 @@
 //
 
 #include "../Assert.h"
+#include "../Trace.h"
 #include "BufferManagerDawn.h"
 
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
@@ -22,7 +24,7 @@ bool RingBufferDawn::push(const wgpu::CommandEncoder &encoder,
                           const wgpu::Buffer &destBuffer,
                           size_t src_offset,
                           size_t dest_offset,
-                          void *pixels,
+                          const void *pixels,
                           size_t size) {
   memcpy(static_cast<unsigned char *>(mPixels) + src_offset, pixels, size);
   encoder.CopyBufferToBuffer(mBuf, src_offset, destBuffer, dest_offset, size);
@@ -53,8 +55,13 @@ void RingBufferDawn::MapCallback(WGPUBufferMapAsyncStatus status,
 
   RingBufferDawn *ringBuffer = static_cast<RingBufferDawn *>(userdata);
   ringBuffer->mappedData = ringBuffer->mBuf.GetMappedRange();
+  ringBuffer->mPixels = ringBuffer->mappedData;
+  ringBuffer->mBufferManager->mPendingMapCount--;
 
-  ringBuffer->mBufferManager->mMappedBufferList.push(ringBuffer);
+  // Slots of the frame ring are tracked by the frame index in sync mode.
+  if (!ringBuffer->mBufferManager->mSync) {
+    ringBuffer->mBufferManager->mMappedBufferList.push(ringBuffer);
+  }
 }
 
 void RingBufferDawn::flush() {
@@ -62,6 +69,7 @@ void RingBufferDawn::flush() {
   mTail = 0;
 
   mBuf.Unmap();
+  mPixels = nullptr;
 }
 
 void RingBufferDawn::destory() {
@@ -69,28 +77,67 @@ void RingBufferDawn::destory() {
 }
 
 void RingBufferDawn::reMap() {
+  mBufferManager->mPendingMapCount++;
   mBuf.MapAsync(wgpu::MapMode::Write, 0, 0, MapCallback, this);
 }
 
 size_t RingBufferDawn::allocate(size_t size) {
   mTail += size;
-  ASSERT(mTail < mSize);
+  ASSERT(mTail <= mSize);
 
   return mTail - size;
 }
 
-BufferManagerDawn::BufferManagerDawn(ContextDawn *context, bool sync)
-    : mContext(context), mSync(sync) {
+namespace {
+
+// Copies between buffers require 4 byte aligned offsets.
+size_t alignCopyOffset(size_t size) {
+  return (size + 3) & ~static_cast<size_t>(3);
+}
+
+}  // namespace
+
+BufferManagerDawn::BufferManagerDawn(ContextDawn *context,
+                                     bool sync,
+                                     size_t framesInFlight)
+    : mContext(context),
+      mSync(sync),
+      mFrameRing(),
+      mFrameIndex(0),
+      mFrameStarted(false),
+      mFrameUploadSize(0),
+      mPeakFrameUploadSize(0),
+      mPendingMapCount(0),
+      mStallTime() {
   mEncoder = context->createCommandEncoder();
+  if (mSync) {
+    for (size_t i = 0; i < framesInFlight; ++i) {
+      mFrameRing.push_back(new RingBufferDawn(this, kMinStagingSize));
+    }
+  }
 }
 
 BufferManagerDawn::~BufferManagerDawn() {
+  // Let pending mappings complete before their callbacks lose the buffers.
+  while (mPendingMapCount > 0) {
+    mContext->WaitABit();
+  }
+
+  for (RingBufferDawn *ringBuffer : mFrameRing) {
+    delete ringBuffer;
+  }
+  for (RingBufferDawn *ringBuffer : mOverflowBuffers) {
+    delete ringBuffer;
+  }
+  for (RingBufferDawn *ringBuffer : mAsyncBuffers) {
+    delete ringBuffer;
+  }
   mEncoder = nullptr;
 }
 
 // Allocate new buffer from buffer pool.
 RingBufferDawn *BufferManagerDawn::allocate(size_t size, size_t *offset) {
-  // If update data by sync method, create new buffer to upload every frame.
+  // If update data by sync method, stage it in the frame ring.
   // If updaye data by async method, get new buffer from pool if available. If
   // no available buffer and size is enough in the buffer pool, create a new
   // buffer. If size reach the limit of the buffer pool, force wait for the
@@ -103,13 +150,7 @@ RingBufferDawn *BufferManagerDawn::allocate(size_t size, size_t *offset) {
   RingBufferDawn *ringBuffer = nullptr;
   size_t cur_offset = 0;
   if (mSync) {
-    // Upper limit
-    if (mUsedSize + size > mBufferPoolSize) {
-      return nullptr;
-    }
-
-    ringBuffer = new RingBufferDawn(this, size);
-    mEnqueuedBufferList.emplace_back(ringBuffer);
+    return allocateFromFrameRing(size, offset);
   } else  // Buffer mapping async
   {
     while (!mMappedBufferList.empty()) {
@@ -126,14 +167,18 @@ RingBufferDawn *BufferManagerDawn::allocate(size_t size, size_t *offset) {
       if (mCount < BUFFER_MAX_COUNT) {
         mUsedSize += size;
         ringBuffer = new RingBufferDawn(this, BUFFER_PER_ALLOCATE_SIZE);
+        mAsyncBuffers.push_back(ringBuffer);
         mMappedBufferList.push(ringBuffer);
         mCount++;
       } else if (mMappedBufferList.size() + mEnqueuedBufferList.size() <
                  mCount) {
         // Force wait for the buffer remapping
+        TRACE_SCOPE("waitForRingBuffer");
+        auto begin = std::chrono::steady_clock::now();
         while (mMappedBufferList.empty()) {
           mContext->WaitABit();
         }
+        mStallTime += std::chrono::steady_clock::now() - begin;
 
         ringBuffer = static_cast<RingBufferDawn *>(mMappedBufferList.front());
         if (ringBuffer->getAvailableSize() < size) {
@@ -182,24 +227,86 @@ void BufferManagerDawn::flush() {
       ringBuffer->reMap();
     }
   } else {
-    // All buffers are used once in buffer sync mode.
-    for (size_t index = 0; index < mEnqueuedBufferList.size(); index++) {
-      delete mEnqueuedBufferList[index];
-    }
-    mUsedSize = 0;
+    retireFrame();
   }
 
   mEnqueuedBufferList.clear();
   mEncoder = mContext->createCommandEncoder();
 }
 
-void BufferManagerDawn::destroyBufferPool() {
-  if (!mSync) {
+// Sub-allocate uploads of the frame from the staging buffer of its slot. A slot
+// is remapped once its frame is submitted, and Dawn completes the mapping only
+// after the queue is done with the frame, so a mapped slot is free to reuse.
+RingBufferDawn *BufferManagerDawn::allocateFromFrameRing(size_t size,
+                                                         size_t *offset) {
+  RingBufferDawn *ringBuffer = mFrameRing[mFrameIndex];
+  if (!mFrameStarted) {
+    waitForMapping(ringBuffer);
+
+    // Grow the slot geometrically to hold the largest frame so far.
+    if (ringBuffer->getSize() < mPeakFrameUploadSize) {
+      size_t capacity = ringBuffer->getSize();
+      while (capacity < mPeakFrameUploadSize) {
+        capacity *= 2;
+      }
+      ringBuffer->destory();
+      delete ringBuffer;
+      ringBuffer = new RingBufferDawn(this, capacity);
+      mFrameRing[mFrameIndex] = ringBuffer;
+    }
+
+    mEnqueuedBufferList.emplace_back(ringBuffer);
+    mFrameStarted = true;
+  }
+
+  size_t alignedSize = alignCopyOffset(size);
+  mFrameUploadSize += alignedSize;
+  if (ringBuffer->getAvailableSize() >= alignedSize) {
+    *offset = ringBuffer->allocate(alignedSize);
+    return ringBuffer;
+  }
+
+  // The slot is grown the next time it's used. Upload by a temporary buffer
+  // this time.
+  if (mUsedSize + alignedSize > mBufferPoolSize) {
+    return nullptr;
+  }
+  RingBufferDawn *overflowBuffer = new RingBufferDawn(this, alignedSize);
+  mUsedSize += alignedSize;
+  mOverflowBuffers.push_back(overflowBuffer);
+  mEnqueuedBufferList.emplace_back(overflowBuffer);
+  *offset = overflowBuffer->allocate(alignedSize);
+  return overflowBuffer;
+}
+
+void BufferManagerDawn::retireFrame() {
+  if (mFrameStarted) {
+    mFrameRing[mFrameIndex]->reMap();
+  }
+
+  // Temporary buffers stay alive until the queue is done with them, as Dawn
+  // holds references of buffers used by submitted commands.
+  for (RingBufferDawn *ringBuffer : mOverflowBuffers) {
+    delete ringBuffer;
+  }
+  mOverflowBuffers.clear();
+  mUsedSize = 0;
+
+  mPeakFrameUploadSize = std::max(mPeakFrameUploadSize, mFrameUploadSize);
+  mFrameUploadSize = 0;
+  mFrameStarted = false;
+  mFrameIndex = (mFrameIndex + 1) % mFrameRing.size();
+}
+
+void BufferManagerDawn::waitForMapping(const RingBufferDawn *ringBuffer) {
+  if (ringBuffer->isMapped()) {
     return;
   }
 
-  for (auto ringBuffer : mEnqueuedBufferList) {
-    ringBuffer->destory();
+  TRACE_SCOPE("waitForMapping");
+  auto begin = std::chrono::steady_clock::now();
+  while (!ringBuffer->isMapped()) {
+    mContext->WaitABit();
   }
-  mEnqueuedBufferList.clear();
+  mStallTime += std::chrono::steady_clock::now() - begin;
 }
@@ -9,6 +9,7 @@
 #ifndef BUFFERMANAGERDAWN_H
 #define BUFFERMANAGERDAWN_H
 
+#include <chrono>
 #include <vector>
 
 #include "dawn/webgpu_cpp.h"
@@ -28,13 +29,15 @@ public:
             const wgpu::Buffer &destBuffer,
             size_t src_offset,
             size_t dest_offset,
-            void *pixels,
+            const void *pixels,
             size_t size);
   bool reset(size_t size) override;
   void flush() override;
   void destory() override;
   void reMap();
   size_t allocate(size_t size) override;
+  // Staging data can only be written while the buffer is mapped.
+  bool isMapped() const { return mPixels != nullptr; }
 
 private:
   static void MapCallback(WGPUBufferMapAsyncStatus status, void *userdata);
@@ -48,16 +51,50 @@ private:
 
 class BufferManagerDawn : public BufferManager {
 public:
-  BufferManagerDawn(ContextDawn *context, bool sync);
+  // Uploads of a frame in sync mode are staged in the buffer of its slot in
+  // the frame ring, so up to framesInFlight frames can be in flight before
+  // a slot has to wait for the queue.
+  static constexpr size_t kFramesInFlight = 3;
+  static constexpr size_t kMinStagingSize = 1 << 20;
+
+  BufferManagerDawn(ContextDawn *context,
+                    bool sync,
+                    size_t framesInFlight = kFramesInFlight);
   ~BufferManagerDawn();
 
   RingBufferDawn *allocate(size_t size, size_t *offset) override;
   void flush() override;
-  void destroyBufferPool() override;
+
+  // Time spent waiting for staging buffers to be mapped again.
+  std::chrono::steady_clock::duration getStallTime() const {
+    return mStallTime;
+  }
+  void resetStallTime() { mStallTime = {}; }
 
   wgpu::CommandEncoder mEncoder;
   ContextDawn *mContext;
   bool mSync;
+
+private:
+  friend class RingBufferDawn;
+
+  RingBufferDawn *allocateFromFrameRing(size_t size, size_t *offset);
+  void retireFrame();
+  void waitForMapping(const RingBufferDawn *ringBuffer);
+
+  std::vector<RingBufferDawn *> mFrameRing;
+  size_t mFrameIndex;
+  bool mFrameStarted;
+  // Bytes staged in the current frame, and the most staged in a frame.
+  size_t mFrameUploadSize;
+  size_t mPeakFrameUploadSize;
+  // Temporary buffers of uploads that overflowed the slot of the frame.
+  std::vector<RingBufferDawn *> mOverflowBuffers;
+  // Buffers created in async mode.
+  std::vector<RingBufferDawn *> mAsyncBuffers;
+
+  int mPendingMapCount;
+  std::chrono::steady_clock::duration mStallTime;
 };
 
 #endif  // BUFFERMANAGERDAWN_H
@@ -7,7 +7,10 @@
 
 #include "ContextDawn.h"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -27,7 +30,10 @@
 
 #include "../Aquarium.h"
 #include "../Assert.h"
+#include "../BlobCache.h"
 #include "../FishModel.h"
+#include "../FishSimulation.h"
+#include "../Trace.h"
 #include "BufferDawn.h"
 #include "FishModelDawn.h"
 #include "FishModelInstancedDrawDawn.h"
@@ -38,6 +44,7 @@
 #include "ProgramDawn.h"
 #include "SeaweedModelDawn.h"
 #include "TextureDawn.h"
+#include "UploadStrategyDawn.h"
 #include "imgui_impl_dawn.h"
 
 #if defined(OS_WIN)
@@ -53,30 +60,46 @@ ContextDawn::ContextDawn(BACKENDTYPE backendType)
       bindGroupGeneral(nullptr),
       groupLayoutWorld(nullptr),
       bindGroupWorld(nullptr),
-      groupLayoutFishPer(nullptr),
       fishPersBuffer(nullptr),
-      bindGroupFishPers(nullptr),
       fishPers(nullptr),
       mDevice(nullptr),
       mWindow(nullptr),
+      mHeadless(false),
       mInstance(),
       mSwapchain(nullptr),
       mCommandEncoder(nullptr),
       mRenderPass(nullptr),
       mRenderPassDescriptor({}),
+      mBundleEncoder(nullptr),
+      mBackgroundBundle(nullptr),
+      mBackgroundBundleFormat(wgpu::TextureFormat::Undefined),
+      mBackgroundBundleSampleCount(0),
       mSceneRenderTargetView(nullptr),
       mSceneDepthStencilView(nullptr),
       mPipeline(nullptr),
       mBindGroup(nullptr),
       mPreferredSwapChainFormat(wgpu::TextureFormat::RGBA8Unorm),
-      bufferManager(nullptr) {
+      mFishSimulationUniforms({}),
+      mEnableGpuFishSimulation(false),
+      mFishSimulationPipeline(nullptr),
+      mFishSimulationGroupLayout(nullptr),
+      mFishSimulationBindGroup(nullptr),
+      mFishSimulationUniformBuffer(nullptr),
+      mFishParamsBuffer(nullptr),
+      mShaderCache(nullptr),
+      mUploadStrategyType(UPLOADSTRATEGY::UPLOADSTAGING),
+      mUploadStrategy(nullptr) {
   mResourceHelper = new ResourceHelper("dawn", "", backendType);
+  if (mResourceHelper->createCacheFolder()) {
+    mShaderCache = new BlobCache(mResourceHelper->getCachePath(), "spirv-");
+  }
   glslang::InitializeProcess();
   initAvailableToggleBitset(backendType);
 }
 
 ContextDawn::~ContextDawn() {
   glslang::FinalizeProcess();
+  delete mShaderCache;
   delete mResourceHelper;
   if (mWindow != nullptr && !mDisableControlPanel) {
     destoryImgUI();
@@ -85,6 +108,7 @@ ContextDawn::~ContextDawn() {
   mSceneRenderTargetView = nullptr;
   mSceneDepthStencilView = nullptr;
   mBackbufferView = nullptr;
+  mOffscreenView = nullptr;
   mPipeline = nullptr;
   mBindGroup = nullptr;
   mLightWorldPositionBuffer = nullptr;
@@ -94,14 +118,20 @@ ContextDawn::~ContextDawn() {
   mCommandBuffers.clear();
   mRenderPass = nullptr;
   mRenderPassDescriptor = {};
+  mBundleEncoder = nullptr;
+  mBackgroundBundle = nullptr;
   groupLayoutGeneral = nullptr;
   bindGroupGeneral = nullptr;
   groupLayoutWorld = nullptr;
   bindGroupWorld = nullptr;
 
-  groupLayoutFishPer = nullptr;
+  mFishSimulationPipeline = nullptr;
+  mFishSimulationGroupLayout = nullptr;
+  mFishSimulationBindGroup = nullptr;
+  mFishSimulationUniformBuffer = nullptr;
+  mFishParamsBuffer = nullptr;
   destoryFishResource();
-  delete bufferManager;
+  delete mUploadStrategy;
 
   mSwapchain = nullptr;
   queue = nullptr;
@@ -149,43 +179,18 @@ bool ContextDawn::initialize(
 
   mDisableControlPanel =
       toggleBitset.test(static_cast<TOGGLE>(TOGGLE::DISABLECONTROLPANEL));
-
-  // initialise GLFW
-  if (!glfwInit()) {
-    std::cout << "Failed to initialise GLFW" << std::endl;
-    return false;
-  }
-
-  // Without this GLFW will initialize a GL context on the window, which
-  // prevents using the window with other APIs (by crashing in weird ways).
-  glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-  // set full screen
-  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
-
-  GLFWmonitor *pMonitor = glfwGetPrimaryMonitor();
-  const GLFWvidmode *mode = glfwGetVideoMode(pMonitor);
-  mClientWidth = mode->width;
-  mClientHeight = mode->height;
-
-  setWindowSize(windowWidth, windowHeight);
-
-  if (toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE))) {
-    mWindow = glfwCreateWindow(mClientWidth, mClientHeight, "Aquarium",
-                               pMonitor, nullptr);
-  } else {
-    mWindow = glfwCreateWindow(mClientWidth, mClientHeight, "Aquarium", nullptr,
-                               nullptr);
-  }
-
-  if (mWindow == nullptr) {
-    std::cout << "Failed to open GLFW window." << std::endl;
-    glfwTerminate();
+  mEnableGpuFishSimulation =
+      toggleBitset.test(static_cast<TOGGLE>(TOGGLE::GPUFISHSIMULATION));
+
+  mHeadless = toggleBitset.test(static_cast<size_t>(TOGGLE::HEADLESS));
+  if (mHeadless) {
+    mClientWidth = kHeadlessWidth;
+    mClientHeight = kHeadlessHeight;
+    setWindowSize(windowWidth, windowHeight);
+  } else if (!createWindow(toggleBitset, windowWidth, windowHeight)) {
     return false;
   }
 
-  // Get the resolution of screen
-  glfwGetFramebufferSize(mWindow, &mClientWidth, &mClientHeight);
-
   mInstance = std::make_unique<dawn_native::Instance>();
 
   // Enable debug layer in Debug mode
@@ -196,8 +201,12 @@ bool ContextDawn::initialize(
   mInstance->DiscoverDefaultAdapters();
 
   dawn_native::Adapter backendAdapter;
-  if (!GetHardwareAdapter(mInstance, &backendAdapter, backendType,
-                          toggleBitset)) {
+  if (mHeadless) {
+    if (!GetHeadlessAdapter(mInstance, &backendAdapter, backendType)) {
+      return false;
+    }
+  } else if (!GetHardwareAdapter(mInstance, &backendAdapter, backendType,
+                                 toggleBitset)) {
     return false;
   }
 
@@ -223,15 +232,29 @@ bool ContextDawn::initialize(
   mDevice = wgpu::Device::Acquire(backendDevice);
 
   queue = mDevice.GetQueue();
-  wgpu::SwapChainDescriptor swapChainDesc;
-  swapChainDesc.implementation =
-      reinterpret_cast<uintptr_t>(getSwapChainImplementation(backendType));
+  if (mHeadless) {
+    // The offscreen texture stands in for the back buffer.
+    wgpu::TextureDescriptor offscreenDesc;
+    offscreenDesc.dimension = wgpu::TextureDimension::e2D;
+    offscreenDesc.size.width = mClientWidth;
+    offscreenDesc.size.height = mClientHeight;
+    offscreenDesc.size.depthOrArrayLayers = 1;
+    offscreenDesc.sampleCount = 1;
+    offscreenDesc.format = mPreferredSwapChainFormat;
+    offscreenDesc.mipLevelCount = 1;
+    offscreenDesc.usage = kSwapchainBackBufferUsage;
+    mOffscreenView = mDevice.CreateTexture(&offscreenDesc).CreateView();
+  } else {
+    wgpu::SwapChainDescriptor swapChainDesc;
+    swapChainDesc.implementation =
+        reinterpret_cast<uintptr_t>(getSwapChainImplementation(backendType));
 
-  mSwapchain = mDevice.CreateSwapChain(nullptr, &swapChainDesc);
+    mSwapchain = mDevice.CreateSwapChain(nullptr, &swapChainDesc);
 
-  mPreferredSwapChainFormat = getPreferredSwapChainTextureFormat(backendType);
-  mSwapchain.Configure(mPreferredSwapChainFormat, kSwapchainBackBufferUsage,
-                       mClientWidth, mClientHeight);
+    mPreferredSwapChainFormat = getPreferredSwapChainTextureFormat(backendType);
+    mSwapchain.Configure(mPreferredSwapChainFormat, kSwapchainBackBufferUsage,
+                         mClientWidth, mClientHeight);
+  }
 
   dawn_native::PCIInfo info = backendAdapter.GetPCIInfo();
   std::string renderer = info.name;
@@ -248,7 +271,7 @@ bool ContextDawn::initialize(
 
   // TODO(jiawei.shao@intel.com): support recreating swapchain when window is
   // resized on all backends
-  if (backend & BACKENDTYPE::BACKENDTYPEVULKAN) {
+  if (!mHeadless && (backend & BACKENDTYPE::BACKENDTYPEVULKAN)) {
     glfwSetFramebufferSizeCallback(mWindow, framebufferResizeCallback);
     glfwSetWindowUserPointer(mWindow, this);
   }
@@ -268,9 +291,7 @@ bool ContextDawn::initialize(
     ImGui_ImplGlfw_InitForOpenGL(mWindow, true);
     ImGui_ImplDawn_Init(this, mPreferredSwapChainFormat);
   }
-  bufferManager = new BufferManagerDawn(
-      this,
-      !toggleBitset.test(static_cast<TOGGLE>(TOGGLE::BUFFERMAPPINGASYNC)));
+  mUploadStrategy = UploadStrategyDawn::create(this, mUploadStrategyType);
 
   return true;
 }
@@ -283,6 +304,83 @@ void ContextDawn::framebufferResizeCallback(GLFWwindow *window,
   contextDawn->mIsSwapchainOutOfDate = true;
 }
 
+bool ContextDawn::createWindow(
+    const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
+    int windowWidth,
+    int windowHeight) {
+  // initialise GLFW
+  if (!glfwInit()) {
+    std::cout << "Failed to initialise GLFW" << std::endl;
+    return false;
+  }
+
+  // Without this GLFW will initialize a GL context on the window, which
+  // prevents using the window with other APIs (by crashing in weird ways).
+  glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+  // set full screen
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWmonitor *pMonitor = glfwGetPrimaryMonitor();
+  const GLFWvidmode *mode = glfwGetVideoMode(pMonitor);
+  mClientWidth = mode->width;
+  mClientHeight = mode->height;
+
+  setWindowSize(windowWidth, windowHeight);
+
+  if (toggleBitset.test(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE))) {
+    mWindow = glfwCreateWindow(mClientWidth, mClientHeight, "Aquarium",
+                               pMonitor, nullptr);
+  } else {
+    mWindow = glfwCreateWindow(mClientWidth, mClientHeight, "Aquarium", nullptr,
+                               nullptr);
+  }
+
+  if (mWindow == nullptr) {
+    std::cout << "Failed to open GLFW window." << std::endl;
+    glfwTerminate();
+    return false;
+  }
+
+  // Get the resolution of screen
+  glfwGetFramebufferSize(mWindow, &mClientWidth, &mClientHeight);
+
+  return true;
+}
+
+// Gpu-less hosts may not have an adapter of the backend. Fall back to a cpu
+// adapter such as SwiftShader, then to the Null backend, which renders
+// nothing but still runs the cpu side of every frame.
+bool ContextDawn::GetHeadlessAdapter(
+    std::unique_ptr<dawn_native::Instance> &instance,
+    dawn_native::Adapter *backendAdapter,
+    wgpu::BackendType backendType) {
+  int bestRank = 0;
+  for (auto &adapter : instance->GetAdapters()) {
+    wgpu::AdapterProperties properties;
+    adapter.GetProperties(&properties);
+    int rank = 0;
+    if (properties.backendType == backendType) {
+      rank = 3;
+    } else if (properties.backendType == wgpu::BackendType::Null) {
+      rank = 1;
+    } else if (adapter.GetDeviceType() == dawn_native::DeviceType::CPU) {
+      rank = 2;
+    }
+
+    if (rank > bestRank) {
+      *backendAdapter = adapter;
+      bestRank = rank;
+    }
+  }
+
+  if (bestRank == 0) {
+    std::cerr << "Failed to create adapter." << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 bool ContextDawn::GetHardwareAdapter(
     std::unique_ptr<dawn_native::Instance> &instance,
     dawn_native::Adapter *backendAdapter,
@@ -337,20 +435,18 @@ void ContextDawn::initAvailableToggleBitset(BACKENDTYPE backendType) {
   mAvailableToggleBitset.set(
       static_cast<size_t>(TOGGLE::SIMULATINGFISHCOMEANDGO));
   mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::DRAWPERMODEL));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::GPUFISHSIMULATION));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::HEADLESS));
 }
 
 Texture *ContextDawn::createTexture(const std::string &name,
                                     const std::string &url) {
-  Texture *texture = new TextureDawn(this, name, url);
-  texture->loadTexture();
-  return texture;
+  return new TextureDawn(this, name, url);
 }
 
 Texture *ContextDawn::createTexture(const std::string &name,
                                     const std::vector<std::string> &urls) {
-  Texture *texture = new TextureDawn(this, name, urls);
-  texture->loadTexture();
-  return texture;
+  return new TextureDawn(this, name, urls);
 }
 
 wgpu::Texture ContextDawn::createTexture(
@@ -427,9 +523,45 @@ wgpu::CommandBuffer ContextDawn::copyBufferToBuffer(
   return copy;
 }
 
+// Look up SPIR-V of the shader in the cache before compiling it. Blending and
+// alpha are substituted into the source by ProgramDawn, so the source covers
+// them.
 wgpu::ShaderModule ContextDawn::createShaderModule(
     wgpu::ShaderStage stage,
     const std::string &str) const {
+  std::string key = std::to_string(static_cast<uint32_t>(stage)) + "\n" +
+                    std::to_string(glslang::GetSpirvGeneratorVersion()) +
+                    "\n" + str;
+  std::vector<uint32_t> code;
+  std::vector<char> blob;
+  if (mShaderCache != nullptr && mShaderCache->load(key, &blob) &&
+      !blob.empty() && blob.size() % sizeof(uint32_t) == 0) {
+    code.resize(blob.size() / sizeof(uint32_t));
+    memcpy(code.data(), blob.data(), blob.size());
+  } else {
+    if (!compileShader(stage, str, &code)) {
+      return {};
+    }
+    if (mShaderCache != nullptr &&
+        !mShaderCache->store(key, code.data(),
+                             code.size() * sizeof(uint32_t))) {
+      std::cerr << "Failed to write shader cache." << std::endl;
+    }
+  }
+
+  wgpu::ShaderModuleSPIRVDescriptor spirvDescriptor;
+  spirvDescriptor.codeSize = static_cast<uint32_t>(code.size());
+  spirvDescriptor.code = code.data();
+
+  wgpu::ShaderModuleDescriptor descriptor;
+  descriptor.nextInChain = &spirvDescriptor;
+
+  return mDevice.CreateShaderModule(&descriptor);
+}
+
+bool ContextDawn::compileShader(wgpu::ShaderStage stage,
+                                const std::string &str,
+                                std::vector<uint32_t> *code) const {
   EShLanguage language;
   switch (stage) {
   case wgpu::ShaderStage::Vertex:
@@ -438,6 +570,9 @@ wgpu::ShaderModule ContextDawn::createShaderModule(
   case wgpu::ShaderStage::Fragment:
     language = EShLanguage::EShLangFragment;
     break;
+  case wgpu::ShaderStage::Compute:
+    language = EShLanguage::EShLangCompute;
+    break;
   default:
     ASSERT(false);
   }
@@ -566,7 +701,7 @@ wgpu::ShaderModule ContextDawn::createShaderModule(
     if (!shader.parse(&resources, 450, EProfile::ECoreProfile, false, false,
                       EShMessages::EShMsgDefault)) {
       std::cerr << shader.getInfoLog();
-      return {};
+      return false;
     }
   }
 
@@ -574,13 +709,12 @@ wgpu::ShaderModule ContextDawn::createShaderModule(
   program.addShader(&shader);
   if (!program.link(EShMessages::EShMsgDefault)) {
     std::cerr << program.getInfoLog();
-    return {};
+    return false;
   }
 
-  std::vector<uint32_t> code;
   {
     glslang::SpvOptions options;
-    glslang::GlslangToSpv(*program.getIntermediate(language), code, &options);
+    glslang::GlslangToSpv(*program.getIntermediate(language), *code, &options);
   }
 #if 0
   {
@@ -588,18 +722,11 @@ wgpu::ShaderModule ContextDawn::createShaderModule(
     spvtools::OptimizerOptions options;
     optimizer.RegisterPerformancePasses();
     options.set_run_validator(false);
-    optimizer.Run(code.data(), code.size(), &code, options);
+    optimizer.Run(code->data(), code->size(), code, options);
   }
 #endif
 
-  wgpu::ShaderModuleSPIRVDescriptor spirvDescriptor;
-  spirvDescriptor.codeSize = static_cast<uint32_t>(code.size());
-  spirvDescriptor.code = code.data();
-
-  wgpu::ShaderModuleDescriptor descriptor;
-  descriptor.nextInChain = &spirvDescriptor;
-
-  return mDevice.CreateShaderModule(&descriptor);
+  return true;
 }
 
 wgpu::BindGroupLayout ContextDawn::MakeBindGroupLayout(
@@ -836,50 +963,148 @@ void ContextDawn::initGeneralResources(Aquarium *aquarium) {
 
   bool enableDynamicBufferOffset = aquarium->toggleBitset.test(
       static_cast<size_t>(TOGGLE::ENABLEDYNAMICBUFFEROFFSET));
-  {
-    std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntry;
-    if (enableDynamicBufferOffset) {
-      bindGroupLayoutEntry.resize(1);
-      bindGroupLayoutEntry[0].binding = 0;
-      bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Vertex;
-      bindGroupLayoutEntry[0].buffer.type = wgpu::BufferBindingType::Uniform;
-      bindGroupLayoutEntry[0].buffer.hasDynamicOffset = true;
-      bindGroupLayoutEntry[0].buffer.minBindingSize = 0;
-    } else {
-      bindGroupLayoutEntry.resize(1);
-      bindGroupLayoutEntry[0].binding = 0;
-      bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Vertex;
-      bindGroupLayoutEntry[0].buffer.type = wgpu::BufferBindingType::Uniform;
-      bindGroupLayoutEntry[0].buffer.hasDynamicOffset = false;
-      bindGroupLayoutEntry[0].buffer.minBindingSize = 0;
-    }
-    groupLayoutFishPer = MakeBindGroupLayout(bindGroupLayoutEntry);
+
+  if (mEnableGpuFishSimulation) {
+    initFishSimulationResources();
   }
 
   reallocResource(aquarium->getPreFishCount(), aquarium->getCurFishCount(),
                   enableDynamicBufferOffset);
 }
 
+void ContextDawn::initFishSimulationResources() {
+  {
+    std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntry;
+    bindGroupLayoutEntry.resize(3);
+    bindGroupLayoutEntry[0].binding = 0;
+    bindGroupLayoutEntry[0].visibility = wgpu::ShaderStage::Compute;
+    bindGroupLayoutEntry[0].buffer.type = wgpu::BufferBindingType::Uniform;
+    bindGroupLayoutEntry[0].buffer.hasDynamicOffset = false;
+    bindGroupLayoutEntry[0].buffer.minBindingSize = 0;
+    bindGroupLayoutEntry[1].binding = 1;
+    bindGroupLayoutEntry[1].visibility = wgpu::ShaderStage::Compute;
+    bindGroupLayoutEntry[1].buffer.type =
+        wgpu::BufferBindingType::ReadOnlyStorage;
+    bindGroupLayoutEntry[1].buffer.hasDynamicOffset = false;
+    bindGroupLayoutEntry[1].buffer.minBindingSize = 0;
+    bindGroupLayoutEntry[2].binding = 2;
+    bindGroupLayoutEntry[2].visibility = wgpu::ShaderStage::Compute;
+    bindGroupLayoutEntry[2].buffer.type = wgpu::BufferBindingType::Storage;
+    bindGroupLayoutEntry[2].buffer.hasDynamicOffset = false;
+    bindGroupLayoutEntry[2].buffer.minBindingSize = 0;
+    mFishSimulationGroupLayout = MakeBindGroupLayout(bindGroupLayoutEntry);
+  }
+
+  std::ifstream shaderStream(
+      mResourceHelper->getProgramPath() + "fishSimulationComputeShader",
+      std::ios::in);
+  std::string shaderCode((std::istreambuf_iterator<char>(shaderStream)),
+                         std::istreambuf_iterator<char>());
+  shaderStream.close();
+
+  wgpu::ComputePipelineDescriptor descriptor;
+  descriptor.layout = MakeBasicPipelineLayout({mFishSimulationGroupLayout});
+  descriptor.compute.module =
+      createShaderModule(wgpu::ShaderStage::Compute, shaderCode);
+  descriptor.compute.entryPoint = "main";
+  mFishSimulationPipeline = mDevice.CreateComputePipeline(&descriptor);
+
+  mFishSimulationUniforms.fishSpeed = g_fishSpeed;
+  mFishSimulationUniforms.fishOffset = g_fishOffset;
+  mFishSimulationUniforms.tailOffsetMult = g_tailOffsetMult;
+  mFishSimulationUniforms.fishXClock = g_fishXClock;
+  mFishSimulationUniforms.fishYClock = g_fishYClock;
+  mFishSimulationUniforms.fishZClock = g_fishZClock;
+
+  wgpu::BufferDescriptor bufferDescriptor;
+  bufferDescriptor.usage =
+      wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
+  bufferDescriptor.size =
+      CalcConstantBufferByteSize(sizeof(FishSimulationUniforms));
+  bufferDescriptor.mappedAtCreation = false;
+  mFishSimulationUniformBuffer = createBuffer(bufferDescriptor);
+}
+
 void ContextDawn::updateWorldlUniforms(Aquarium *aquarium) {
   updateBufferData(
       mLightWorldPositionBuffer,
       CalcConstantBufferByteSize(sizeof(LightWorldPositionUniform)),
       &aquarium->lightWorldPositionUniform, sizeof(LightWorldPositionUniform));
+
+  // The clock is the only per frame input of fish simulation on gpu. It's
+  // uploaded by dispatchFishSimulation, after the fish count may change.
+  mFishSimulationUniforms.clock = aquarium->g.mclock;
+}
+
+// Pack per fish parameters in the order of fishPers. The buffers are bound
+// with their capacity, so the bind group is kept until they are reallocated.
+void ContextDawn::updateFishParams(Aquarium *aquarium) {
+  if (!mEnableGpuFishSimulation || mCurTotalInstance == 0) {
+    return;
+  }
+
+  const FishSimulation *fishSimulation = aquarium->getFishSimulation();
+  mFishParams.resize(mCurTotalInstance);
+  int fishIndex = 0;
+  for (int fishType = 0; fishType < NUM_FISH_TYPES; ++fishType) {
+    const Fish &fishInfo = fishTable[fishType];
+    int numFish = fishSimulation->getFishCount(fishType);
+    for (int ii = 0; ii < numFish; ++ii) {
+      FishParam &param = mFishParams[fishIndex++];
+      param.speed = fishSimulation->getSpeed(fishType)[ii];
+      param.scale = fishSimulation->getScale(fishType)[ii];
+      param.xRadius = fishSimulation->getXRadius(fishType)[ii];
+      param.yRadius = fishSimulation->getYRadius(fishType)[ii];
+      param.zRadius = fishSimulation->getZRadius(fishType)[ii];
+      param.index = static_cast<float>(ii);
+      param.fishHeight = g_fishHeight + fishInfo.heightOffset;
+      param.fishTailSpeed = fishInfo.tailSpeed * g_fishTailSpeed;
+    }
+  }
+  ASSERT(fishIndex == mCurTotalInstance);
+  mFishSimulationUniforms.fishCount = static_cast<uint32_t>(mCurTotalInstance);
+
+  setBufferData(mFishParamsBuffer, sizeof(FishParam) * mCurTotalInstance,
+                mFishParams.data(), sizeof(FishParam) * mCurTotalInstance);
+}
+
+// Record the compute pass in its own command buffer. It's submitted after the
+// uniform upload of the buffer manager and before the render pass.
+void ContextDawn::dispatchFishSimulation() {
+  constexpr uint32_t kWorkgroupSize = 64;
+
+  if (mCurTotalInstance == 0) {
+    return;
+  }
+
+  updateBufferData(mFishSimulationUniformBuffer,
+                   CalcConstantBufferByteSize(sizeof(FishSimulationUniforms)),
+                   &mFishSimulationUniforms, sizeof(FishSimulationUniforms));
+
+  wgpu::CommandEncoder encoder = mDevice.CreateCommandEncoder();
+  wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+  pass.SetPipeline(mFishSimulationPipeline);
+  pass.SetBindGroup(0, mFishSimulationBindGroup, 0, nullptr);
+  pass.Dispatch((mCurTotalInstance + kWorkgroupSize - 1) / kWorkgroupSize);
+  pass.EndPass();
+  mCommandBuffers.emplace_back(encoder.Finish());
 }
 
 Buffer *ContextDawn::createBuffer(int numComponents,
-                                  std::vector<float> *buf,
+                                  const float *buf,
+                                  int totalComponents,
                                   bool isIndex) {
-  Buffer *buffer = new BufferDawn(this, static_cast<int>(buf->size()),
-                                  numComponents, buf, isIndex);
+  Buffer *buffer =
+      new BufferDawn(this, totalComponents, numComponents, buf, isIndex);
   return buffer;
 }
 
 Buffer *ContextDawn::createBuffer(int numComponents,
-                                  std::vector<unsigned short> *buf,
+                                  const unsigned short *buf,
+                                  int totalComponents,
                                   bool isIndex) {
-  Buffer *buffer = new BufferDawn(this, static_cast<int>(buf->size()),
-                                  numComponents, buf, isIndex);
+  Buffer *buffer =
+      new BufferDawn(this, totalComponents, numComponents, buf, isIndex);
   return buffer;
 }
 
@@ -891,14 +1116,23 @@ Program *ContextDawn::createProgram(const std::string &mVId,
 }
 
 void ContextDawn::setWindowTitle(const std::string &text) {
+  if (mHeadless) {
+    return;
+  }
   glfwSetWindowTitle(mWindow, text.c_str());
 }
 
 bool ContextDawn::ShouldQuit() {
+  if (mHeadless) {
+    return false;
+  }
   return glfwWindowShouldClose(mWindow);
 }
 
 void ContextDawn::KeyBoardQuit() {
+  if (mHeadless) {
+    return;
+  }
   if (glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     glfwSetWindowShouldClose(mWindow, GLFW_TRUE);
 }
@@ -906,16 +1140,30 @@ void ContextDawn::KeyBoardQuit() {
 // Submit commands of the frame
 void ContextDawn::DoFlush(
     const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset) {
+  TRACE_SCOPE("DoFlush");
   mRenderPass.EndPass();
 
-  bufferManager->flush();
+  {
+    TRACE_SCOPE("flushUploads");
+    mUploadStrategy->flush();
+  }
 
   wgpu::CommandBuffer cmd = mCommandEncoder.Finish();
   mCommandBuffers.emplace_back(cmd);
 
   Flush();
 
-  mSwapchain.Present();
+  // Nothing is presented in headless mode, tick the device to let it
+  // retire finished work and fire callbacks.
+  if (mHeadless) {
+    mDevice.Tick();
+    return;
+  }
+
+  {
+    TRACE_SCOPE("present");
+    mSwapchain.Present();
+  }
 
   glfwPollEvents();
 }
@@ -929,6 +1177,9 @@ void ContextDawn::Terminate() {
 }
 
 void ContextDawn::showWindow() {
+  if (mHeadless) {
+    return;
+  }
   glfwShowWindow(mWindow);
 }
 
@@ -963,6 +1214,10 @@ void ContextDawn::destoryImgUI() {
 }
 
 void ContextDawn::preFrame() {
+  if (mFishCapacity.shrink(mCurTotalInstance)) {
+    allocateFishResource();
+  }
+
   if (mIsSwapchainOutOfDate) {
     glfwGetFramebufferSize(mWindow, &mClientWidth, &mClientHeight);
     if (mMSAASampleCount > 1) {
@@ -976,7 +1231,8 @@ void ContextDawn::preFrame() {
   }
 
   mCommandEncoder = mDevice.CreateCommandEncoder();
-  mBackbufferView = mSwapchain.GetCurrentTextureView();
+  mBackbufferView =
+      mHeadless ? mOffscreenView : mSwapchain.GetCurrentTextureView();
 
   wgpu::RenderPassColorAttachment colorAttachment;
   if (mMSAASampleCount > 1) {
@@ -1011,6 +1267,38 @@ void ContextDawn::preFrame() {
   mRenderPass = mCommandEncoder.BeginRenderPass(&mRenderPassDescriptor);
 }
 
+void ContextDawn::drawBackground(Model *const *models, int count) {
+  if (mBackgroundBundle == nullptr ||
+      mBackgroundBundleFormat != mPreferredSwapChainFormat ||
+      mBackgroundBundleSampleCount != mMSAASampleCount) {
+    recordBackgroundBundle(models, count);
+  }
+
+  mRenderPass.ExecuteBundles(1, &mBackgroundBundle);
+}
+
+// Bind groups and buffers of background models are created once at init, so
+// that the recorded commands stay valid while their uniforms are updated
+// in place.
+void ContextDawn::recordBackgroundBundle(Model *const *models, int count) {
+  TRACE_SCOPE("recordBackgroundBundle");
+  wgpu::RenderBundleEncoderDescriptor descriptor;
+  descriptor.colorFormatsCount = 1;
+  descriptor.colorFormats = &mPreferredSwapChainFormat;
+  descriptor.depthStencilFormat = wgpu::TextureFormat::Depth24PlusStencil8;
+  descriptor.sampleCount = mMSAASampleCount;
+  mBundleEncoder = mDevice.CreateRenderBundleEncoder(&descriptor);
+
+  for (int i = 0; i < count; ++i) {
+    models[i]->draw();
+  }
+
+  mBackgroundBundle = mBundleEncoder.Finish();
+  mBundleEncoder = nullptr;
+  mBackgroundBundleFormat = mPreferredSwapChainFormat;
+  mBackgroundBundleSampleCount = mMSAASampleCount;
+}
+
 Model *ContextDawn::createModel(Aquarium *aquarium,
                                 MODELGROUP type,
                                 MODELNAME name,
@@ -1048,55 +1336,66 @@ void ContextDawn::reallocResource(int preTotalInstance,
                                   bool enableDynamicBufferOffset) {
   mPreTotalInstance = preTotalInstance;
   mCurTotalInstance = curTotalInstance;
-  mEnableDynamicBufferOffset = enableDynamicBufferOffset;
 
-  if (curTotalInstance == 0)
-    return;
-
-  // If current fish number > pre fish number, allocate a new bigger buffer.
-  // If current fish number <= prefish number, do not allocate a new one.
-  // TODO(yizhou) : optimize the buffer allocation strategy.
-  if (preTotalInstance >= curTotalInstance) {
-    return;
+  // Only reallocate when the fish count outgrows the capacity. preFrame
+  // shrinks it after the count has stayed small for a while.
+  if (mFishCapacity.grow(curTotalInstance)) {
+    allocateFishResource();
   }
+}
 
-  destoryFishResource();
+// Allocate per fish resources to hold the capacity. Their contents are
+// rewritten every frame except per fish parameters of gpu fish simulation,
+// which are uploaded again from mFishParams.
+void ContextDawn::allocateFishResource() {
+  int capacity = mFishCapacity.getCapacity();
 
-  fishPers = new FishPer[curTotalInstance];
+  destoryFishResource();
 
-  if (enableDynamicBufferOffset) {
-    bindGroupFishPers = new wgpu::BindGroup[1];
-  } else {
-    bindGroupFishPers = new wgpu::BindGroup[curTotalInstance];
-  }
+  fishPers = new FishPer[capacity];
 
+  // FishPer is tightly packed and read by fish models as per instance vertex
+  // data.
   wgpu::BufferDescriptor descriptor;
-  descriptor.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
-  descriptor.size =
-      CalcConstantBufferByteSize(sizeof(FishPer) * curTotalInstance);
+  descriptor.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex;
+  if (mEnableGpuFishSimulation) {
+    descriptor.usage |= wgpu::BufferUsage::Storage;
+  }
+  descriptor.size = sizeof(FishPer) * capacity;
   descriptor.mappedAtCreation = false;
   fishPersBuffer = createBuffer(descriptor);
 
-  if (enableDynamicBufferOffset) {
-    std::vector<wgpu::BindGroupEntry> bindGroupEntry;
-    bindGroupEntry.resize(1);
-    bindGroupEntry[0].binding = 0;
-    bindGroupEntry[0].buffer = fishPersBuffer;
-    bindGroupEntry[0].offset = 0;
-    bindGroupEntry[0].size = CalcConstantBufferByteSize(sizeof(FishPer));
-    bindGroupFishPers[0] = makeBindGroup(groupLayoutFishPer, bindGroupEntry);
-  } else {
-    for (int i = 0; i < curTotalInstance; i++) {
-      std::vector<wgpu::BindGroupEntry> bindGroupEntry;
-      bindGroupEntry.resize(1);
-      bindGroupEntry[0].binding = 0;
-      bindGroupEntry[0].buffer = fishPersBuffer;
-      bindGroupEntry[0].offset =
-          CalcConstantBufferByteSize(sizeof(FishPer) * i);
-      bindGroupEntry[0].size = CalcConstantBufferByteSize(sizeof(FishPer));
-      bindGroupFishPers[i] = makeBindGroup(groupLayoutFishPer, bindGroupEntry);
-    }
+  if (!mEnableGpuFishSimulation) {
+    return;
+  }
+
+  descriptor.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+  descriptor.size = sizeof(FishParam) * capacity;
+  mFishParamsBuffer = createBuffer(descriptor);
+  size_t paramsSize =
+      sizeof(FishParam) * std::min<size_t>(mFishParams.size(), capacity);
+  if (paramsSize > 0) {
+    setBufferData(mFishParamsBuffer, paramsSize, mFishParams.data(),
+                  paramsSize);
   }
+
+  std::vector<wgpu::BindGroupEntry> bindGroupEntry;
+  bindGroupEntry.resize(3);
+  bindGroupEntry[0].binding = 0;
+  bindGroupEntry[0].buffer = mFishSimulationUniformBuffer;
+  bindGroupEntry[0].offset = 0;
+  bindGroupEntry[0].size =
+      CalcConstantBufferByteSize(sizeof(FishSimulationUniforms));
+  bindGroupEntry[1].binding = 1;
+  bindGroupEntry[1].buffer = mFishParamsBuffer;
+  bindGroupEntry[1].offset = 0;
+  bindGroupEntry[1].size = sizeof(FishParam) * capacity;
+  bindGroupEntry[2].binding = 2;
+  bindGroupEntry[2].buffer = fishPersBuffer;
+  bindGroupEntry[2].offset = 0;
+  bindGroupEntry[2].size = sizeof(FishPer) * capacity;
+  mFishSimulationBindGroup =
+      makeBindGroup(mFishSimulationGroupLayout, bindGroupEntry);
 }
 
 void ContextDawn::WaitABit() {
@@ -1116,24 +1415,43 @@ wgpu::CommandEncoder ContextDawn::createCommandEncoder() const {
 }
 
 void ContextDawn::updateAllFishData() {
-  size_t size = CalcConstantBufferByteSize(sizeof(FishPer) * mCurTotalInstance);
-  updateBufferData(fishPersBuffer, size, fishPers,
-                   sizeof(FishPer) * mCurTotalInstance);
+  if (mEnableGpuFishSimulation) {
+    dispatchFishSimulation();
+    return;
+  }
+
+  size_t size = sizeof(FishPer) * mCurTotalInstance;
+  updateBufferData(fishPersBuffer, size, fishPers, size);
 }
 
 void ContextDawn::updateBufferData(const wgpu::Buffer &buffer,
                                    size_t bufferSize,
-                                   void *data,
+                                   const void *data,
                                    size_t dataSize) const {
-  size_t offset = 0;
-  RingBufferDawn *ringBuffer = bufferManager->allocate(bufferSize, &offset);
+  mUploadStrategy->upload(buffer, bufferSize, data, dataSize);
+}
 
-  if (ringBuffer == nullptr) {
-    std::cout << "Memory upper limit." << std::endl;
-    return;
+// Switching between frames releases the staging buffers of the old strategy
+// once the gpu is done with them.
+bool ContextDawn::setUploadStrategy(UPLOADSTRATEGY strategy) {
+  if (strategy < 0 || strategy >= UPLOADSTRATEGY::UPLOADMAX) {
+    return false;
   }
 
-  ringBuffer->push(bufferManager->mEncoder, buffer, offset, 0, data, dataSize);
+  mUploadStrategyType = strategy;
+  if (mUploadStrategy != nullptr) {
+    delete mUploadStrategy;
+    mUploadStrategy = UploadStrategyDawn::create(this, strategy);
+  }
+  return true;
+}
+
+UploadStats ContextDawn::getUploadStats() const {
+  return mUploadStrategy->getStats();
+}
+
+void ContextDawn::resetUploadStats() {
+  mUploadStrategy->resetStats();
 }
 
 void ContextDawn::destoryFishResource() {
@@ -1143,25 +1461,6 @@ void ContextDawn::destoryFishResource() {
     delete[] fishPers;
     fishPers = nullptr;
   }
-  if (mEnableDynamicBufferOffset) {
-    if (bindGroupFishPers != nullptr) {
-      if (bindGroupFishPers[0].Get() != nullptr) {
-        bindGroupFishPers[0] = nullptr;
-      }
-    }
-  } else {
-    if (bindGroupFishPers != nullptr) {
-      for (int i = 0; i < mPreTotalInstance; i++) {
-        if (bindGroupFishPers[i].Get() != nullptr) {
-          bindGroupFishPers[i] = nullptr;
-        }
-      }
-    }
-  }
-
-  bindGroupFishPers = nullptr;
-
-  bufferManager->destroyBufferPool();
 }
 
 size_t ContextDawn::CalcConstantBufferByteSize(size_t byteSize) const {
@@ -39,10 +39,11 @@
 
 #include "../Aquarium.h"
 #include "../Context.h"
-#include "BufferManagerDawn.h"
+#include "../InstanceCapacity.h"
 
-class BufferManagerDawn;
+class BlobCache;
 class ProgramDawn;
+class UploadStrategyDawn;
 
 class ContextDawn : public Context {
 public:
@@ -71,16 +72,23 @@ public:
   void destoryImgUI() override;
 
   void preFrame() override;
+  void drawBackground(Model *const *models, int count) override;
+
+  bool setUploadStrategy(UPLOADSTRATEGY strategy) override;
+  UploadStats getUploadStats() const override;
+  void resetUploadStats() override;
 
   Model *createModel(Aquarium *aquarium,
                      MODELGROUP type,
                      MODELNAME name,
                      bool blend) override;
   Buffer *createBuffer(int numComponents,
-                       std::vector<float> *buffer,
+                       const float *buffer,
+                       int totalComponents,
                        bool isIndex) override;
   Buffer *createBuffer(int numComponents,
-                       std::vector<unsigned short> *buffer,
+                       const unsigned short *buffer,
+                       int totalComponents,
                        bool isIndex) override;
 
   Program *createProgram(const std::string &mVId,
@@ -137,8 +145,13 @@ public:
 
   void initGeneralResources(Aquarium *aquarium) override;
   void updateWorldlUniforms(Aquarium *aquarium) override;
+  void updateFishParams(Aquarium *aquarium) override;
   const wgpu::Device &getDevice() const { return mDevice; }
   const wgpu::RenderPassEncoder &getRenderPass() const { return mRenderPass; }
+  // Background models record their draws here, see drawBackground().
+  const wgpu::RenderBundleEncoder &getBundleEncoder() const {
+    return mBundleEncoder;
+  }
 
   void reallocResource(int preTotalInstance,
                        int curTotalInstance,
@@ -146,7 +159,7 @@ public:
   void updateAllFishData() override;
   void updateBufferData(const wgpu::Buffer &buffer,
                         size_t bufferSize,
-                        void *data,
+                        const void *data,
                         size_t dataSize) const;
   void WaitABit();
   wgpu::CommandEncoder createCommandEncoder() const;
@@ -160,9 +173,7 @@ public:
   wgpu::BindGroupLayout groupLayoutWorld;
   wgpu::BindGroup bindGroupWorld;
 
-  wgpu::BindGroupLayout groupLayoutFishPer;
   wgpu::Buffer fishPersBuffer;
-  wgpu::BindGroup *bindGroupFishPers;
 
   FishPer *fishPers;
 
@@ -172,13 +183,22 @@ protected:
   explicit ContextDawn(BACKENDTYPE backendType);
 
   GLFWwindow *mWindow;
+  // Render into mOffscreenView instead of a swapchain, without a window.
+  bool mHeadless;
 
 private:
+  bool createWindow(
+      const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
+      int windowWidth,
+      int windowHeight);
   bool GetHardwareAdapter(
       std::unique_ptr<dawn_native::Instance> &instance,
       dawn_native::Adapter *backendAdapter,
       wgpu::BackendType backendType,
       const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset);
+  bool GetHeadlessAdapter(std::unique_ptr<dawn_native::Instance> &instance,
+                          dawn_native::Adapter *backendAdapter,
+                          wgpu::BackendType backendType);
   virtual DawnSwapChainImplementation *getSwapChainImplementation(
       wgpu::BackendType backendType) = 0;
   virtual wgpu::TextureFormat getPreferredSwapChainTextureFormat(
@@ -188,7 +208,14 @@ private:
   static void framebufferResizeCallback(GLFWwindow *window,
                                         int width,
                                         int height);
+  bool compileShader(wgpu::ShaderStage stage,
+                     const std::string &str,
+                     std::vector<uint32_t> *code) const;
+  void allocateFishResource();
   void destoryFishResource();
+  void initFishSimulationResources();
+  void dispatchFishSimulation();
+  void recordBackgroundBundle(Model *const *models, int count);
 
   // TODO(jiawei.shao@intel.com): remove wgpu::TextureUsageBit::CopyDst when the
   // bug in Dawn is fixed.
@@ -203,7 +230,16 @@ private:
   wgpu::RenderPassEncoder mRenderPass;
   wgpu::RenderPassDescriptor mRenderPassDescriptor;
 
+  // Draws of background models are recorded once and replayed every frame.
+  // The bundle is bound to the attachment formats and sample count it's
+  // recorded with.
+  wgpu::RenderBundleEncoder mBundleEncoder;
+  wgpu::RenderBundle mBackgroundBundle;
+  wgpu::TextureFormat mBackgroundBundleFormat;
+  int mBackgroundBundleSampleCount;
+
   wgpu::TextureView mBackbufferView;
+  wgpu::TextureView mOffscreenView;
   wgpu::TextureView mSceneRenderTargetView;
   wgpu::TextureView mSceneDepthStencilView;
   wgpu::RenderPipeline mPipeline;
@@ -214,9 +250,45 @@ private:
   wgpu::Buffer mLightBuffer;
   wgpu::Buffer mFogBuffer;
 
-  bool mEnableDynamicBufferOffset;
-
-  BufferManagerDawn *bufferManager;
+  // Fish simulation on gpu. The layouts match fishSimulationComputeShader.
+  struct FishSimulationUniforms {
+    float clock;
+    float fishSpeed;
+    float fishOffset;
+    float tailOffsetMult;
+    float fishXClock;
+    float fishYClock;
+    float fishZClock;
+    uint32_t fishCount;
+  } mFishSimulationUniforms;
+
+  struct FishParam {
+    float speed;
+    float scale;
+    float xRadius;
+    float yRadius;
+    float zRadius;
+    float index;
+    float fishHeight;
+    float fishTailSpeed;
+  };
+
+  bool mEnableGpuFishSimulation;
+  wgpu::ComputePipeline mFishSimulationPipeline;
+  wgpu::BindGroupLayout mFishSimulationGroupLayout;
+  wgpu::BindGroup mFishSimulationBindGroup;
+  wgpu::Buffer mFishSimulationUniformBuffer;
+  wgpu::Buffer mFishParamsBuffer;
+  std::vector<FishParam> mFishParams;
+
+  // Compiled SPIR-V keyed on the shader stage, source and compiler version.
+  BlobCache *mShaderCache;
+
+  // Capacity of fishPers, fishPersBuffer and mFishParamsBuffer in fishes.
+  InstanceCapacity mFishCapacity;
+
+  UPLOADSTRATEGY mUploadStrategyType;
+  UploadStrategyDawn *mUploadStrategy;
 };
 
 #endif  // CONTEXTDAWN_H
@@ -7,6 +7,7 @@
 
 #include "FishModelDawn.h"
 
+#include <cstddef>
 #include <iostream>
 #include <vector>
 
@@ -53,7 +54,7 @@ void FishModelDawn::init() {
   mIndicesBuffer = static_cast<BufferDawn *>(bufferMap["indices"]);
 
   std::vector<wgpu::VertexAttribute> vertexAttribute;
-  vertexAttribute.resize(5);
+  vertexAttribute.resize(9);
   vertexAttribute[0].format = wgpu::VertexFormat::Float32x3;
   vertexAttribute[0].offset = 0;
   vertexAttribute[0].shaderLocation = 0;
@@ -69,9 +70,21 @@ void FishModelDawn::init() {
   vertexAttribute[4].format = wgpu::VertexFormat::Float32x3;
   vertexAttribute[4].offset = 0;
   vertexAttribute[4].shaderLocation = 4;
+  vertexAttribute[5].format = wgpu::VertexFormat::Float32x3;
+  vertexAttribute[5].offset = offsetof(FishPer, worldPosition);
+  vertexAttribute[5].shaderLocation = 5;
+  vertexAttribute[6].format = wgpu::VertexFormat::Float32;
+  vertexAttribute[6].offset = offsetof(FishPer, scale);
+  vertexAttribute[6].shaderLocation = 6;
+  vertexAttribute[7].format = wgpu::VertexFormat::Float32x3;
+  vertexAttribute[7].offset = offsetof(FishPer, nextPosition);
+  vertexAttribute[7].shaderLocation = 7;
+  vertexAttribute[8].format = wgpu::VertexFormat::Float32;
+  vertexAttribute[8].offset = offsetof(FishPer, time);
+  vertexAttribute[8].shaderLocation = 8;
 
   std::vector<wgpu::VertexBufferLayout> vertexBufferLayout;
-  vertexBufferLayout.resize(5);
+  vertexBufferLayout.resize(6);
   vertexBufferLayout[0].arrayStride = mPositionBuffer->getDataSize();
   vertexBufferLayout[0].stepMode = wgpu::InputStepMode::Vertex;
   vertexBufferLayout[0].attributeCount = 1;
@@ -92,6 +105,10 @@ void FishModelDawn::init() {
   vertexBufferLayout[4].stepMode = wgpu::InputStepMode::Vertex;
   vertexBufferLayout[4].attributeCount = 1;
   vertexBufferLayout[4].attributes = &vertexAttribute[4];
+  vertexBufferLayout[5].arrayStride = sizeof(FishPer);
+  vertexBufferLayout[5].stepMode = wgpu::InputStepMode::Instance;
+  vertexBufferLayout[5].attributeCount = 4;
+  vertexBufferLayout[5].attributes = &vertexAttribute[5];
 
   mVertexState.module = mVsModule;
   mVertexState.entryPoint = "main";
@@ -175,7 +192,6 @@ void FishModelDawn::init() {
       mContextDawn->groupLayoutGeneral,
       mContextDawn->groupLayoutWorld,
       mGroupLayoutModel,
-      mContextDawn->groupLayoutFishPer,
   });
 
   mPipeline = mContextDawn->createRenderPipeline(mPipelineLayout, mProgramDawn,
@@ -260,16 +276,18 @@ void FishModelDawn::draw() {
   pass.SetIndexBuffer(mIndicesBuffer->getBuffer(), wgpu::IndexFormat::Uint16, 0,
                       0);
 
+  // Each fish is drawn as a single instance, its FishPer is picked either by
+  // the first instance of the draw or by the offset of the vertex buffer.
   if (mEnableDynamicBufferOffset) {
+    pass.SetVertexBuffer(5, mContextDawn->fishPersBuffer);
     for (int i = 0; i < mCurInstance; i++) {
-      uint32_t offset = 256u * (i + mFishPerOffset);
-      pass.SetBindGroup(3, mContextDawn->bindGroupFishPers[0], 1, &offset);
-      pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), 1, 0, 0, 0);
+      pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), 1, 0, 0,
+                       i + mFishPerOffset);
     }
   } else {
     for (int i = 0; i < mCurInstance; i++) {
-      pass.SetBindGroup(3, mContextDawn->bindGroupFishPers[i + mFishPerOffset],
-                        0, nullptr);
+      pass.SetVertexBuffer(5, mContextDawn->fishPersBuffer,
+                           sizeof(FishPer) * (i + mFishPerOffset));
       pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), 1, 0, 0, 0);
     }
   }
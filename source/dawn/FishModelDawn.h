@@ -36,6 +36,9 @@ public:
                              float scale,
                              float time,
                              int index) override;
+  FishPer *getFishPers() override {
+    return mContextDawn->fishPers + mFishPerOffset;
+  }
 
   struct FishVertexUniforms {
     float fishLength;
@@ -322,10 +322,14 @@ void GenericModelDawn::init() {
 void GenericModelDawn::prepareForDraw() {
   mContextDawn->updateBufferData(mWorldBuffer, sizeof(WorldUniformPer),
                                  &mWorldUniformPer, sizeof(WorldUniformPer));
+
+  // Instances are counted again by updatePerInstanceUniforms every frame,
+  // while the draw is recorded only once.
+  instance = 0;
 }
 
 void GenericModelDawn::draw() {
-  wgpu::RenderPassEncoder pass = mContextDawn->getRenderPass();
+  wgpu::RenderBundleEncoder pass = mContextDawn->getBundleEncoder();
   pass.SetPipeline(mPipeline);
   pass.SetBindGroup(0, mContextDawn->bindGroupGeneral, 0, nullptr);
   pass.SetBindGroup(1, mContextDawn->bindGroupWorld, 0, nullptr);
@@ -342,7 +346,6 @@ void GenericModelDawn::draw() {
   pass.SetIndexBuffer(mIndicesBuffer->getBuffer(), wgpu::IndexFormat::Uint16, 0,
                       0);
   pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), instance, 0, 0, 0);
-  instance = 0;
 }
 
 void GenericModelDawn::updatePerInstanceUniforms(
@@ -351,3 +354,17 @@ void GenericModelDawn::updatePerInstanceUniforms(
 
   instance++;
 }
+
+void GenericModelDawn::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    copyWorldUniforms(worlds[i], worldInverseTransposes[i],
+                      worldViewProjections[i],
+                      &mWorldUniformPer.WorldUniforms[i]);
+  }
+
+  instance = static_cast<int>(count);
+}
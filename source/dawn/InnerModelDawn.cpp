@@ -208,7 +208,7 @@ void InnerModelDawn::prepareForDraw() {
 }
 
 void InnerModelDawn::draw() {
-  wgpu::RenderPassEncoder pass = mContextDawn->getRenderPass();
+  wgpu::RenderBundleEncoder pass = mContextDawn->getBundleEncoder();
   pass.SetPipeline(mPipeline);
   pass.SetBindGroup(0, mContextDawn->bindGroupGeneral, 0, nullptr);
   pass.SetBindGroup(1, mContextDawn->bindGroupWorld, 0, nullptr);
@@ -233,3 +233,21 @@ void InnerModelDawn::updatePerInstanceUniforms(
       mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniforms)),
       &mWorldUniformPer, sizeof(WorldUniforms));
 }
+
+void InnerModelDawn::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  // The inner tank is drawn once.
+  if (count == 0) {
+    return;
+  }
+  copyWorldUniforms(worlds[0], worldInverseTransposes[0],
+                    worldViewProjections[0], &mWorldUniformPer);
+
+  mContextDawn->updateBufferData(
+      mViewBuffer,
+      mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniforms)),
+      &mWorldUniformPer, sizeof(WorldUniforms));
+}
@@ -180,7 +180,7 @@ void OutsideModelDawn::prepareForDraw() {
 }
 
 void OutsideModelDawn::draw() {
-  wgpu::RenderPassEncoder pass = mContextDawn->getRenderPass();
+  wgpu::RenderBundleEncoder pass = mContextDawn->getBundleEncoder();
   pass.SetPipeline(mPipeline);
   pass.SetBindGroup(0, mContextDawn->bindGroupGeneral, 0, nullptr);
   pass.SetBindGroup(1, mContextDawn->bindGroupWorld, 0, nullptr);
@@ -208,3 +208,21 @@ void OutsideModelDawn::updatePerInstanceUniforms(
       mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniforms) * 20),
       &mWorldUniformPer, sizeof(WorldUniforms));
 }
+
+void OutsideModelDawn::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  // The outside is drawn once.
+  if (count == 0) {
+    return;
+  }
+  copyWorldUniforms(worlds[0], worldInverseTransposes[0],
+                    worldViewProjections[0], &mWorldUniformPer[0]);
+
+  mContextDawn->updateBufferData(
+      mViewBuffer,
+      mContextDawn->CalcConstantBufferByteSize(sizeof(WorldUniforms) * 20),
+      &mWorldUniformPer, sizeof(WorldUniforms));
+}
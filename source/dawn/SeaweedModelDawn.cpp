@@ -184,10 +184,14 @@ void SeaweedModelDawn::prepareForDraw() {
   mContextDawn->updateBufferData(
       mTimeBuffer, mContextDawn->CalcConstantBufferByteSize(sizeof(SeaweedPer)),
       &mSeaweedPer, sizeof(SeaweedPer));
+
+  // Instances are counted again by updatePerInstanceUniforms every frame,
+  // while the draw is recorded only once.
+  instance = 0;
 }
 
 void SeaweedModelDawn::draw() {
-  wgpu::RenderPassEncoder pass = mContextDawn->getRenderPass();
+  wgpu::RenderBundleEncoder pass = mContextDawn->getBundleEncoder();
   pass.SetPipeline(mPipeline);
   pass.SetBindGroup(0, mContextDawn->bindGroupGeneral, 0, nullptr);
   pass.SetBindGroup(1, mContextDawn->bindGroupWorld, 0, nullptr);
@@ -199,7 +203,6 @@ void SeaweedModelDawn::draw() {
   pass.SetIndexBuffer(mIndicesBuffer->getBuffer(), wgpu::IndexFormat::Uint16, 0,
                       0);
   pass.DrawIndexed(mIndicesBuffer->getTotalComponents(), instance, 0, 0, 0);
-  instance = 0;
 }
 
 void SeaweedModelDawn::updatePerInstanceUniforms(
@@ -210,5 +213,21 @@ void SeaweedModelDawn::updatePerInstanceUniforms(
   instance++;
 }
 
+void SeaweedModelDawn::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    copyWorldUniforms(worlds[i], worldInverseTransposes[i],
+                      worldViewProjections[i],
+                      &mWorldUniformPer.worldUniforms[i]);
+    mSeaweedPer.seaweed[i].time =
+        mAquarium->g.mclock + static_cast<float>(i);
+  }
+
+  instance = static_cast<int>(count);
+}
+
 void SeaweedModelDawn::updateSeaweedModelTime(float time) {
 }
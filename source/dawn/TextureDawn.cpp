@@ -15,9 +15,6 @@
 #include "ContextDawn.h"
 
 TextureDawn::~TextureDawn() {
-
-  DestoryImageData(mPixelVec);
-  DestoryImageData(mResizedVec);
   mTextureView = nullptr;
   mTexture = nullptr;
   mSampler = nullptr;
@@ -46,10 +43,49 @@ TextureDawn::TextureDawn(ContextDawn *context,
       mContext(context) {
 }
 
+// Rows of buffer to texture copies are 256 bytes aligned, so 2D textures are
+// padded to a multiple of 256 pixels.
+int TextureDawn::getResizedWidth(int width) {
+  const int kPadding = 256;
+  if (width % kPadding == 0) {
+    return width;
+  }
+  return (width / kPadding + 1) * kPadding;
+}
+
+void TextureDawn::processImages() {
+  if (mTextureViewDimension == wgpu::TextureViewDimension::Cube) {
+    Texture::processImages();
+    return;
+  }
+
+  int resizedWidth = getResizedWidth(mWidth);
+  generateMipmap(mPixelVec[0], mWidth, mHeight, 0, mResizedVec, resizedWidth,
+                 mHeight, 0, 4, true);
+  std::vector<size_t> imageSizes;
+  getImageSizes(mWidth, mHeight, &imageSizes);
+  ASSERT(imageSizes.size() == mResizedVec.size());
+  for (size_t i = 0; i < mResizedVec.size(); ++i) {
+    addImage(mResizedVec[i], imageSizes[i]);
+  }
+}
+
+void TextureDawn::getImageSizes(int width,
+                                int height,
+                                std::vector<size_t> *imageSizes) const {
+  if (mTextureViewDimension == wgpu::TextureViewDimension::Cube) {
+    Texture::getImageSizes(width, height, imageSizes);
+    return;
+  }
+
+  getMipImageSizes(getResizedWidth(width), height, true, imageSizes);
+}
+
 void TextureDawn::loadTexture() {
   wgpu::SamplerDescriptor samplerDesc = {};
-  const int kPadding = 256;
-  loadImage(mUrls, &mPixelVec);
+  if (!mPrepared) {
+    prepareTexture();
+  }
 
   if (mTextureViewDimension == wgpu::TextureViewDimension::Cube) {
     wgpu::TextureDescriptor descriptor;
@@ -71,7 +107,7 @@ void TextureDawn::loadTexture() {
       descriptor.size = mWidth * mHeight * 4;
       descriptor.mappedAtCreation = true;
       wgpu::Buffer staging = mContext->createBuffer(descriptor);
-      memcpy(staging.GetMappedRange(), mPixelVec[i], mWidth * mHeight * 4);
+      memcpy(staging.GetMappedRange(), mImageVec[i], mWidth * mHeight * 4);
       staging.Unmap();
 
       wgpu::ImageCopyBuffer imageCopyBuffer =
@@ -105,14 +141,7 @@ void TextureDawn::loadTexture() {
     mSampler = mContext->createSampler(samplerDesc);
   } else  // wgpu::TextureViewDimension::e2D
   {
-    int resizedWidth;
-    if (mWidth % kPadding == 0) {
-      resizedWidth = mWidth;
-    } else {
-      resizedWidth = (mWidth / 256 + 1) * 256;
-    }
-    generateMipmap(mPixelVec[0], mWidth, mHeight, 0, mResizedVec, resizedWidth,
-                   mHeight, 0, 4, true);
+    int resizedWidth = getResizedWidth(mWidth);
 
     wgpu::TextureDescriptor descriptor;
     descriptor.dimension = mTextureDimension;
@@ -143,7 +172,7 @@ void TextureDawn::loadTexture() {
       descriptor.size = resizedWidth * height * 4;
       descriptor.mappedAtCreation = true;
       wgpu::Buffer staging = mContext->createBuffer(descriptor);
-      memcpy(staging.GetMappedRange(), mResizedVec[i],
+      memcpy(staging.GetMappedRange(), mImageVec[i],
              resizedWidth * height * 4);
       staging.Unmap();
 
@@ -186,5 +215,6 @@ void TextureDawn::loadTexture() {
     mSampler = mContext->createSampler(samplerDesc);
   }
 
-  // TODO(yizhou): check if the pixel destory should delay or fence
+  // Images are copied to staging buffers already.
+  releaseImages();
 }
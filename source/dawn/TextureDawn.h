@@ -35,14 +35,18 @@ public:
   void loadTexture() override;
 
 private:
+  void processImages() override;
+  void getImageSizes(int width,
+                     int height,
+                     std::vector<size_t> *imageSizes) const override;
+  static int getResizedWidth(int width);
+
   wgpu::TextureDimension mTextureDimension;  // texture 2D or CubeMap
   wgpu::TextureViewDimension mTextureViewDimension;
   wgpu::Texture mTexture;
   wgpu::Sampler mSampler;
   wgpu::TextureFormat mFormat;
   wgpu::TextureView mTextureView;
-  std::vector<unsigned char *> mPixelVec;
-  std::vector<unsigned char *> mResizedVec;
   ContextDawn *mContext;
 };
 
@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// UploadStrategyDawn.cpp: Implement strategies to upload per frame data for
+// Dawn backend.
+
+#include "UploadStrategyDawn.h"
+
+#include <iostream>
+
+#include "BufferManagerDawn.h"
+#include "ContextDawn.h"
+
+UploadStrategyDawn *UploadStrategyDawn::create(ContextDawn *context,
+                                               UPLOADSTRATEGY strategy) {
+  switch (strategy) {
+  case UPLOADSTRATEGY::UPLOADSTAGING:
+    return new StagingUploadDawn(context, true,
+                                 BufferManagerDawn::kFramesInFlight);
+  case UPLOADSTRATEGY::UPLOADMAPPINGASYNC:
+    return new StagingUploadDawn(context, false, 0);
+  case UPLOADSTRATEGY::UPLOADWRITEBUFFER:
+    return new WriteBufferUploadDawn(context);
+  default:
+    return nullptr;
+  }
+}
+
+UploadStrategyDawn::UploadStrategyDawn() : mStats() {}
+
+void UploadStrategyDawn::upload(const wgpu::Buffer &buffer,
+                                size_t bufferSize,
+                                const void *data,
+                                size_t dataSize) {
+  auto begin = std::chrono::steady_clock::now();
+  if (!doUpload(buffer, bufferSize, data, dataSize)) {
+    std::cout << "Memory upper limit." << std::endl;
+    return;
+  }
+  mStats.uploadTime += std::chrono::steady_clock::now() - begin;
+  mStats.uploadedBytes += dataSize;
+}
+
+void UploadStrategyDawn::flush() {
+  auto begin = std::chrono::steady_clock::now();
+  doFlush();
+  mStats.uploadTime += std::chrono::steady_clock::now() - begin;
+}
+
+UploadStats UploadStrategyDawn::getStats() const {
+  UploadStats stats = mStats;
+  stats.stallTime = getStallTime();
+  return stats;
+}
+
+void UploadStrategyDawn::resetStats() {
+  mStats = UploadStats();
+  resetStallTime();
+}
+
+StagingUploadDawn::StagingUploadDawn(ContextDawn *context,
+                                     bool sync,
+                                     size_t framesInFlight)
+    : mBufferManager(new BufferManagerDawn(context, sync, framesInFlight)) {}
+
+StagingUploadDawn::~StagingUploadDawn() {
+  delete mBufferManager;
+}
+
+bool StagingUploadDawn::doUpload(const wgpu::Buffer &buffer,
+                                 size_t bufferSize,
+                                 const void *data,
+                                 size_t dataSize) {
+  size_t offset = 0;
+  RingBufferDawn *ringBuffer = mBufferManager->allocate(bufferSize, &offset);
+  if (ringBuffer == nullptr) {
+    return false;
+  }
+
+  ringBuffer->push(mBufferManager->mEncoder, buffer, offset, 0, data,
+                   dataSize);
+  return true;
+}
+
+void StagingUploadDawn::doFlush() {
+  mBufferManager->flush();
+}
+
+std::chrono::steady_clock::duration StagingUploadDawn::getStallTime() const {
+  return mBufferManager->getStallTime();
+}
+
+void StagingUploadDawn::resetStallTime() {
+  mBufferManager->resetStallTime();
+}
+
+WriteBufferUploadDawn::WriteBufferUploadDawn(ContextDawn *context)
+    : mContext(context) {}
+
+bool WriteBufferUploadDawn::doUpload(const wgpu::Buffer &buffer,
+                                     size_t bufferSize,
+                                     const void *data,
+                                     size_t dataSize) {
+  mContext->queue.WriteBuffer(buffer, 0, data, dataSize);
+  return true;
+}
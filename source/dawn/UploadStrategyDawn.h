@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// UploadStrategyDawn.h: Define strategies to upload per frame data to buffers
+// for Dawn backend. Uploads of a frame are recorded by upload() while models
+// are drawn, and flush() makes them visible to the commands of the frame
+// before they are submitted.
+
+#ifndef UPLOADSTRATEGYDAWN_H
+#define UPLOADSTRATEGYDAWN_H
+
+#include "dawn/webgpu_cpp.h"
+
+#include "../Aquarium.h"
+
+class BufferManagerDawn;
+class ContextDawn;
+
+class UploadStrategyDawn {
+public:
+  static UploadStrategyDawn *create(ContextDawn *context,
+                                    UPLOADSTRATEGY strategy);
+
+  virtual ~UploadStrategyDawn() {}
+
+  // Upload dataSize bytes of data to the beginning of buffer. bufferSize is
+  // the size of buffer reserved for the upload, and dataSize is no more than
+  // it.
+  void upload(const wgpu::Buffer &buffer,
+              size_t bufferSize,
+              const void *data,
+              size_t dataSize);
+  void flush();
+
+  UploadStats getStats() const;
+  void resetStats();
+
+protected:
+  UploadStrategyDawn();
+
+  virtual bool doUpload(const wgpu::Buffer &buffer,
+                        size_t bufferSize,
+                        const void *data,
+                        size_t dataSize) = 0;
+  virtual void doFlush() = 0;
+  virtual std::chrono::steady_clock::duration getStallTime() const {
+    return {};
+  }
+  virtual void resetStallTime() {}
+
+private:
+  UploadStats mStats;
+};
+
+// Copy the data to mapped staging buffers of a BufferManagerDawn, and record
+// copies from them to the destination buffers.
+class StagingUploadDawn : public UploadStrategyDawn {
+public:
+  StagingUploadDawn(ContextDawn *context, bool sync, size_t framesInFlight);
+  ~StagingUploadDawn() override;
+
+protected:
+  bool doUpload(const wgpu::Buffer &buffer,
+                size_t bufferSize,
+                const void *data,
+                size_t dataSize) override;
+  void doFlush() override;
+  std::chrono::steady_clock::duration getStallTime() const override;
+  void resetStallTime() override;
+
+private:
+  BufferManagerDawn *mBufferManager;
+};
+
+// Hand the data to the queue, which stages it in memory managed by Dawn.
+class WriteBufferUploadDawn : public UploadStrategyDawn {
+public:
+  explicit WriteBufferUploadDawn(ContextDawn *context);
+
+protected:
+  bool doUpload(const wgpu::Buffer &buffer,
+                size_t bufferSize,
+                const void *data,
+                size_t dataSize) override;
+  void doFlush() override {}
+
+private:
+  ContextDawn *mContext;
+};
+
+#endif  // UPLOADSTRATEGYDAWN_H
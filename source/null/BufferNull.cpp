@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BufferNull.cpp: Implement the buffer of the null backend.
+
+#include "BufferNull.h"
+
+BufferNull::BufferNull(int numComponents,
+                       const void *buffer,
+                       size_t elementSize,
+                       int totalComponents,
+                       bool isIndex)
+    : mNumComponents(numComponents),
+      mTotalComponents(totalComponents),
+      mIsIndex(isIndex) {
+  const uint8_t *data = static_cast<const uint8_t *>(buffer);
+  mData.assign(data, data + elementSize * totalComponents);
+}
@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// BufferNull.h: Define the buffer of the null backend. It keeps a copy of the
+// data in place of gpu memory.
+
+#ifndef BUFFERNULL_H
+#define BUFFERNULL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../Buffer.h"
+
+class BufferNull : public Buffer {
+public:
+  BufferNull(int numComponents,
+             const void *buffer,
+             size_t elementSize,
+             int totalComponents,
+             bool isIndex);
+
+  int getNumComponents() const { return mNumComponents; }
+  int getTotalComponents() const { return mTotalComponents; }
+  bool isIndex() const { return mIsIndex; }
+
+private:
+  int mNumComponents;
+  int mTotalComponents;
+  bool mIsIndex;
+  std::vector<uint8_t> mData;
+};
+
+#endif  // BUFFERNULL_H
@@ -0,0 +1,216 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ContextNull.cpp: Implement the null backend.
+
+#include "ContextNull.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "BufferNull.h"
+#include "FishModelNull.h"
+#include "GenericModelNull.h"
+#include "ProgramNull.h"
+#include "SeaweedModelNull.h"
+#include "TextureNull.h"
+
+ContextNull::ContextNull(BACKENDTYPE backendType)
+    : mFishPers(nullptr), mStagingOffset(0), mUploadStats() {
+  mResourceHelper = new ResourceHelper("null", "", backendType);
+  initAvailableToggleBitset(backendType);
+}
+
+ContextNull::~ContextNull() {
+  delete[] mFishPers;
+  delete mResourceHelper;
+}
+
+ContextNull *ContextNull::create(BACKENDTYPE backendType) {
+  return new ContextNull(backendType);
+}
+
+bool ContextNull::initialize(
+    BACKENDTYPE backend,
+    const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
+    int windowWidth,
+    int windowHeight) {
+  // Nothing is shown, the size only goes into the projection matrix.
+  mDisableControlPanel = true;
+  mClientWidth = kHeadlessWidth;
+  mClientHeight = kHeadlessHeight;
+  setWindowSize(windowWidth, windowHeight);
+
+  mResourceHelper->setRenderer("CPU");
+  std::cout << "Null backend renders nothing" << std::endl;
+
+  return true;
+}
+
+Texture *ContextNull::createTexture(const std::string &name,
+                                    const std::string &url) {
+  return new TextureNull(name, url);
+}
+
+Texture *ContextNull::createTexture(const std::string &name,
+                                    const std::vector<std::string> &urls) {
+  return new TextureNull(name, urls);
+}
+
+Buffer *ContextNull::createBuffer(int numComponents,
+                                  const float *buffer,
+                                  int totalComponents,
+                                  bool isIndex) {
+  return new BufferNull(numComponents, buffer, sizeof(float), totalComponents,
+                        isIndex);
+}
+
+Buffer *ContextNull::createBuffer(int numComponents,
+                                  const unsigned short *buffer,
+                                  int totalComponents,
+                                  bool isIndex) {
+  return new BufferNull(numComponents, buffer, sizeof(unsigned short),
+                        totalComponents, isIndex);
+}
+
+Program *ContextNull::createProgram(const std::string &mVId,
+                                    const std::string &mFId) {
+  return new ProgramNull(mVId, mFId);
+}
+
+void ContextNull::setWindowTitle(const std::string &text) {
+}
+
+// There is no window to close, it runs until --test-time is up.
+bool ContextNull::ShouldQuit() {
+  return false;
+}
+
+void ContextNull::KeyBoardQuit() {
+}
+
+void ContextNull::DoFlush(
+    const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset) {
+}
+
+void ContextNull::Terminate() {
+}
+
+void ContextNull::preFrame() {
+  if (mFishCapacity.shrink(mCurTotalInstance)) {
+    allocateFishResource();
+  }
+
+  mStagingOffset = 0;
+}
+
+void ContextNull::showWindow() {
+}
+
+void ContextNull::updateFPS(
+    const FPSTimer &fpsTimer,
+    int *fishCount,
+    std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> *toggleBitset) {
+}
+
+void ContextNull::destoryImgUI() {
+}
+
+void ContextNull::reallocResource(int preTotalInstance,
+                                  int curTotalInstance,
+                                  bool enableDynamicBufferOffset) {
+  mPreTotalInstance = preTotalInstance;
+  mCurTotalInstance = curTotalInstance;
+
+  // Allocate even if there is no fish yet, so that fish models always find
+  // the FishPer array.
+  if (mFishCapacity.grow(curTotalInstance) || mFishPers == nullptr) {
+    allocateFishResource();
+  }
+}
+
+void ContextNull::allocateFishResource() {
+  delete[] mFishPers;
+  mFishPers = new FishPer[mFishCapacity.getCapacity()];
+}
+
+void ContextNull::updateAllFishData() {
+  uploadData(mFishPers, sizeof(FishPer) * mCurTotalInstance);
+}
+
+Model *ContextNull::createModel(Aquarium *aquarium,
+                                MODELGROUP type,
+                                MODELNAME name,
+                                bool blend) {
+  Model *model;
+  switch (type) {
+  case MODELGROUP::FISH:
+  case MODELGROUP::FISHINSTANCEDDRAW:
+    model = new FishModelNull(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::GENERIC:
+  case MODELGROUP::INNER:
+  case MODELGROUP::OUTSIDE:
+    model = new GenericModelNull(this, aquarium, type, name, blend);
+    break;
+  case MODELGROUP::SEAWEED:
+    model = new SeaweedModelNull(this, aquarium, type, name, blend);
+    break;
+  default:
+    model = nullptr;
+    std::cout << "can not create model type" << std::endl;
+  }
+
+  return model;
+}
+
+void ContextNull::initGeneralResources(Aquarium *aquarium) {
+  reallocResource(aquarium->getPreFishCount(), aquarium->getCurFishCount(),
+                  false);
+}
+
+void ContextNull::updateWorldlUniforms(Aquarium *aquarium) {
+  uploadData(&aquarium->lightWorldPositionUniform,
+             sizeof(LightWorldPositionUniform));
+}
+
+bool ContextNull::setUploadStrategy(UPLOADSTRATEGY strategy) {
+  return strategy == UPLOADSTRATEGY::UPLOADSTAGING;
+}
+
+void ContextNull::resetUploadStats() {
+  mUploadStats = UploadStats();
+}
+
+// Staging memory grows to hold a frame in the first frames, and is reused
+// after that.
+void ContextNull::uploadData(const void *data, size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+
+  if (mStagingOffset + size > mStagingBuffer.size()) {
+    mStagingBuffer.resize(
+        std::max(mStagingBuffer.size() * 2, mStagingOffset + size));
+  }
+  memcpy(mStagingBuffer.data() + mStagingOffset, data, size);
+  mStagingOffset += size;
+
+  mUploadStats.uploadedBytes += size;
+  mUploadStats.uploadTime += std::chrono::steady_clock::now() - begin;
+}
+
+void ContextNull::initAvailableToggleBitset(BACKENDTYPE backendType) {
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::DRAWPERMODEL));
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::HEADLESS));
+  mAvailableToggleBitset.set(
+      static_cast<size_t>(TOGGLE::SIMULATINGFISHCOMEANDGO));
+  // Frames are never throttled.
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::TURNOFFVSYNC));
+}
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ContextNull.h: Define the null backend. It doesn't talk to any graphics API,
+// but does the cpu work of a frame as a gpu backend does: uniforms are packed,
+// fishes are simulated into a FishPer array and per frame data is copied to
+// staging memory. It profiles the cpu side of the aquarium on machines without
+// a usable gpu.
+
+#ifndef CONTEXTNULL_H
+#define CONTEXTNULL_H
+
+#include <chrono>
+#include <vector>
+
+#include "../Aquarium.h"
+#include "../Context.h"
+#include "../InstanceCapacity.h"
+
+class ContextNull : public Context {
+public:
+  static ContextNull *create(BACKENDTYPE backendType);
+
+  ~ContextNull() override;
+
+  bool initialize(
+      BACKENDTYPE backend,
+      const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
+      int windowWidth,
+      int windowHeight) override;
+  Texture *createTexture(const std::string &name,
+                         const std::string &url) override;
+  Texture *createTexture(const std::string &name,
+                         const std::vector<std::string> &urls) override;
+  Buffer *createBuffer(int numComponents,
+                       const float *buffer,
+                       int totalComponents,
+                       bool isIndex) override;
+  Buffer *createBuffer(int numComponents,
+                       const unsigned short *buffer,
+                       int totalComponents,
+                       bool isIndex) override;
+  Program *createProgram(const std::string &mVId,
+                         const std::string &mFId) override;
+  void setWindowTitle(const std::string &text) override;
+  bool ShouldQuit() override;
+  void KeyBoardQuit() override;
+  void DoFlush(const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)>
+                   &toggleBitset) override;
+  void Terminate() override;
+
+  void preFrame() override;
+  void showWindow() override;
+  void updateFPS(const FPSTimer &fpsTimer,
+                 int *fishCount,
+                 std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)>
+                     *toggleBitset) override;
+  void destoryImgUI() override;
+  void reallocResource(int preTotalInstance,
+                       int curTotalInstance,
+                       bool enableDynamicBufferOffset) override;
+  void updateAllFishData() override;
+
+  Model *createModel(Aquarium *aquarium,
+                     MODELGROUP type,
+                     MODELNAME name,
+                     bool blend) override;
+
+  void initGeneralResources(Aquarium *aquarium) override;
+  void updateWorldlUniforms(Aquarium *aquarium) override;
+
+  // Per frame data is copied to staging memory only, there is no other
+  // strategy to choose.
+  bool setUploadStrategy(UPLOADSTRATEGY strategy) override;
+  UploadStats getUploadStats() const override { return mUploadStats; }
+  void resetUploadStats() override;
+
+  FishPer *getFishPers() const { return mFishPers; }
+  // Copy data of the frame to staging memory, which is recycled every frame.
+  void uploadData(const void *data, size_t size);
+
+private:
+  explicit ContextNull(BACKENDTYPE backendType);
+  void initAvailableToggleBitset(BACKENDTYPE backendType) override;
+  void allocateFishResource();
+
+  FishPer *mFishPers;
+  InstanceCapacity mFishCapacity;
+
+  std::vector<char> mStagingBuffer;
+  size_t mStagingOffset;
+  UploadStats mUploadStats;
+};
+
+#endif  // CONTEXTNULL_H
@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishModelNull.cpp: Implement fish model of the null backend.
+
+#include "FishModelNull.h"
+
+#include "ContextNull.h"
+
+FishModelNull::FishModelNull(ContextNull *context,
+                             Aquarium *aquarium,
+                             MODELGROUP type,
+                             MODELNAME name,
+                             bool blend)
+    : FishModel(type, name, blend, aquarium), mContextNull(context) {
+}
+
+void FishModelNull::init() {
+}
+
+void FishModelNull::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+}
+
+void FishModelNull::draw() {
+}
+
+void FishModelNull::updateFishPerUniforms(float x,
+                                          float y,
+                                          float z,
+                                          float nextX,
+                                          float nextY,
+                                          float nextZ,
+                                          float scale,
+                                          float time,
+                                          int index) {
+  FishPer &fishPer = getFishPers()[index];
+  fishPer.worldPosition[0] = x;
+  fishPer.worldPosition[1] = y;
+  fishPer.worldPosition[2] = z;
+  fishPer.nextPosition[0] = nextX;
+  fishPer.nextPosition[1] = nextY;
+  fishPer.nextPosition[2] = nextZ;
+  fishPer.scale = scale;
+  fishPer.time = time;
+}
+
+FishPer *FishModelNull::getFishPers() {
+  return mContextNull->getFishPers() + mFishPerOffset;
+}
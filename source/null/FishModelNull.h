@@ -0,0 +1,44 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// FishModelNull.h: Define fish model of the null backend. Fishes are
+// simulated into the FishPer array of the context, which is uploaded at once
+// for all fish models.
+
+#ifndef FISHMODELNULL_H
+#define FISHMODELNULL_H
+
+#include "../FishModel.h"
+
+class ContextNull;
+
+class FishModelNull : public FishModel {
+public:
+  FishModelNull(ContextNull *context,
+                Aquarium *aquarium,
+                MODELGROUP type,
+                MODELNAME name,
+                bool blend);
+
+  void init() override;
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void draw() override;
+
+  void updateFishPerUniforms(float x,
+                             float y,
+                             float z,
+                             float nextX,
+                             float nextY,
+                             float nextZ,
+                             float scale,
+                             float time,
+                             int index) override;
+  FishPer *getFishPers() override;
+
+private:
+  ContextNull *mContextNull;
+};
+
+#endif  // FISHMODELNULL_H
@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GenericModelNull.cpp: Implement generic, inner and outside models of the
+// null backend.
+
+#include "GenericModelNull.h"
+
+#include "ContextNull.h"
+
+GenericModelNull::GenericModelNull(ContextNull *context,
+                                   Aquarium *aquarium,
+                                   MODELGROUP type,
+                                   MODELNAME name,
+                                   bool blend)
+    : Model(type, name, blend), mContextNull(context), mInstance(0) {
+}
+
+void GenericModelNull::init() {
+}
+
+// Instances are counted again by updatePerInstanceUniforms every frame.
+void GenericModelNull::prepareForDraw() {
+  mInstance = 0;
+}
+
+void GenericModelNull::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+  if (mInstance == static_cast<int>(mWorldUniforms.size())) {
+    mWorldUniforms.push_back(worldUniforms);
+  } else {
+    mWorldUniforms[mInstance] = worldUniforms;
+  }
+
+  mInstance++;
+}
+
+void GenericModelNull::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  if (mWorldUniforms.size() < count) {
+    mWorldUniforms.resize(count);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    copyWorldUniforms(worlds[i], worldInverseTransposes[i],
+                      worldViewProjections[i], &mWorldUniforms[i]);
+  }
+
+  mInstance = static_cast<int>(count);
+}
+
+void GenericModelNull::draw() {
+  mContextNull->uploadData(mWorldUniforms.data(),
+                           sizeof(WorldUniforms) * mInstance);
+}
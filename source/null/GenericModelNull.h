@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// GenericModelNull.h: Define generic, inner and outside models of the null
+// backend. They differ only in shaders and uniforms that are set once.
+
+#ifndef GENERICMODELNULL_H
+#define GENERICMODELNULL_H
+
+#include <vector>
+
+#include "../Model.h"
+
+class ContextNull;
+
+class GenericModelNull : public Model {
+public:
+  GenericModelNull(ContextNull *context,
+                   Aquarium *aquarium,
+                   MODELGROUP type,
+                   MODELNAME name,
+                   bool blend);
+
+  void init() override;
+  void prepareForDraw() override;
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void updateInstanceUniforms(const Mat4 *worlds,
+                              const Mat4 *worldInverseTransposes,
+                              const Mat4 *worldViewProjections,
+                              size_t count) override;
+  void draw() override;
+
+private:
+  ContextNull *mContextNull;
+
+  std::vector<WorldUniforms> mWorldUniforms;
+  int mInstance;
+};
+
+#endif  // GENERICMODELNULL_H
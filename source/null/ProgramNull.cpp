@@ -0,0 +1,16 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ProgramNull.cpp: Implement the program of the null backend.
+
+#include "ProgramNull.h"
+
+ProgramNull::ProgramNull(const std::string &mVId, const std::string &mFId)
+    : Program(mVId, mFId) {
+}
+
+void ProgramNull::compileProgram(bool enableAlphaBlending,
+                                 const std::string &alpha) {
+}
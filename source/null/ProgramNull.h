@@ -0,0 +1,24 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// ProgramNull.h: Define the program of the null backend. There are no shaders
+// to load or compile.
+
+#ifndef PROGRAMNULL_H
+#define PROGRAMNULL_H
+
+#include <string>
+
+#include "../Program.h"
+
+class ProgramNull : public Program {
+public:
+  ProgramNull(const std::string &mVId, const std::string &mFId);
+
+  void compileProgram(bool enableAlphaBlending,
+                      const std::string &alpha) override;
+};
+
+#endif  // PROGRAMNULL_H
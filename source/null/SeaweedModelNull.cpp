@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// SeaweedModelNull.cpp: Implement seaweed model of the null backend.
+
+#include "SeaweedModelNull.h"
+
+#include "ContextNull.h"
+
+SeaweedModelNull::SeaweedModelNull(ContextNull *context,
+                                   Aquarium *aquarium,
+                                   MODELGROUP type,
+                                   MODELNAME name,
+                                   bool blend)
+    : SeaweedModel(type, name, blend),
+      mContextNull(context),
+      mAquarium(aquarium),
+      mInstance(0) {
+}
+
+void SeaweedModelNull::init() {
+}
+
+// Instances are counted again by updatePerInstanceUniforms every frame.
+void SeaweedModelNull::prepareForDraw() {
+  mInstance = 0;
+}
+
+void SeaweedModelNull::updatePerInstanceUniforms(
+    const WorldUniforms &worldUniforms) {
+  float time = mAquarium->g.mclock + mInstance;
+  if (mInstance == static_cast<int>(mWorldUniforms.size())) {
+    mWorldUniforms.push_back(worldUniforms);
+    mTimes.push_back(time);
+  } else {
+    mWorldUniforms[mInstance] = worldUniforms;
+    mTimes[mInstance] = time;
+  }
+
+  mInstance++;
+}
+
+void SeaweedModelNull::updateInstanceUniforms(
+    const Mat4 *worlds,
+    const Mat4 *worldInverseTransposes,
+    const Mat4 *worldViewProjections,
+    size_t count) {
+  if (mWorldUniforms.size() < count) {
+    mWorldUniforms.resize(count);
+    mTimes.resize(count);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    copyWorldUniforms(worlds[i], worldInverseTransposes[i],
+                      worldViewProjections[i], &mWorldUniforms[i]);
+    mTimes[i] = mAquarium->g.mclock + static_cast<float>(i);
+  }
+
+  mInstance = static_cast<int>(count);
+}
+
+void SeaweedModelNull::draw() {
+  mContextNull->uploadData(mWorldUniforms.data(),
+                           sizeof(WorldUniforms) * mInstance);
+  mContextNull->uploadData(mTimes.data(), sizeof(float) * mInstance);
+}
+
+void SeaweedModelNull::updateSeaweedModelTime(float time) {
+}
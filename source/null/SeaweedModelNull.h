@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// SeaweedModelNull.h: Define seaweed model of the null backend.
+
+#ifndef SEAWEEDMODELNULL_H
+#define SEAWEEDMODELNULL_H
+
+#include <vector>
+
+#include "../SeaweedModel.h"
+
+class ContextNull;
+
+class SeaweedModelNull : public SeaweedModel {
+public:
+  SeaweedModelNull(ContextNull *context,
+                   Aquarium *aquarium,
+                   MODELGROUP type,
+                   MODELNAME name,
+                   bool blend);
+
+  void init() override;
+  void prepareForDraw() override;
+  void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
+  void updateInstanceUniforms(const Mat4 *worlds,
+                              const Mat4 *worldInverseTransposes,
+                              const Mat4 *worldViewProjections,
+                              size_t count) override;
+  void draw() override;
+
+  void updateSeaweedModelTime(float time) override;
+
+private:
+  ContextNull *mContextNull;
+  Aquarium *mAquarium;
+
+  std::vector<WorldUniforms> mWorldUniforms;
+  std::vector<float> mTimes;
+  int mInstance;
+};
+
+#endif  // SEAWEEDMODELNULL_H
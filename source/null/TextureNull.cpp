@@ -0,0 +1,33 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TextureNull.cpp: Implement the texture of the null backend.
+
+#include "TextureNull.h"
+
+#include "../Assert.h"
+
+TextureNull::TextureNull(const std::string &name, const std::string &url)
+    : Texture(name, url, true) {
+}
+
+TextureNull::TextureNull(const std::string &name,
+                         const std::vector<std::string> &urls)
+    : Texture(name, urls, false) {
+  ASSERT(urls.size() == 6);
+}
+
+void TextureNull::loadTexture() {
+  if (!mPrepared) {
+    prepareTexture();
+  }
+
+  mData.clear();
+  for (size_t i = 0; i < mImageVec.size(); ++i) {
+    mData.insert(mData.end(), mImageVec[i], mImageVec[i] + mImageSizes[i]);
+  }
+
+  releaseImages();
+}
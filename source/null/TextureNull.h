@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2021 The Aquarium Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// TextureNull.h: Define the texture of the null backend. Images are decoded
+// as for other backends, and copied in place of the upload.
+
+#ifndef TEXTURENULL_H
+#define TEXTURENULL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Texture.h"
+
+class TextureNull : public Texture {
+public:
+  TextureNull(const std::string &name, const std::string &url);
+  TextureNull(const std::string &name, const std::vector<std::string> &urls);
+
+  void loadTexture() override;
+
+private:
+  std::vector<uint8_t> mData;
+};
+
+#endif  // TEXTURENULL_H
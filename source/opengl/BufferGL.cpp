@@ -28,14 +28,14 @@ BufferGL::BufferGL(ContextGL *context,
   mBuf = mContext->generateBuffer();
 }
 
-void BufferGL::loadBuffer(const std::vector<float> &buf) {
+void BufferGL::loadBuffer(const float *buf) {
   mContext->bindBuffer(mTarget, mBuf);
-  mContext->uploadBuffer(mTarget, buf);
+  mContext->uploadBuffer(mTarget, buf, mTotoalComponents);
 }
 
-void BufferGL::loadBuffer(const std::vector<unsigned short> &buf) {
+void BufferGL::loadBuffer(const unsigned short *buf) {
   mContext->bindBuffer(mTarget, mBuf);
-  mContext->uploadBuffer(mTarget, buf);
+  mContext->uploadBuffer(mTarget, buf, mTotoalComponents);
 }
 
 BufferGL::~BufferGL() {
@@ -46,8 +46,8 @@ public:
   int getStride() const { return mStride; }
   void *getOffset() const { return mOffset; }
   unsigned int getTarget() const { return mTarget; }
-  void loadBuffer(const std::vector<float> &buf);
-  void loadBuffer(const std::vector<unsigned short> &buf);
+  void loadBuffer(const float *buf);
+  void loadBuffer(const unsigned short *buf);
 
 private:
   ContextGL *mContext;
@@ -8,6 +8,7 @@
 #include "ContextGL.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -20,6 +21,8 @@
 #endif
 
 #include "../Assert.h"
+#include "../BlobCache.h"
+#include "../Trace.h"
 #include "BufferGL.h"
 #include "FishModelGL.h"
 #include "GenericModelGL.h"
@@ -30,16 +33,77 @@
 #include "TextureGL.h"
 #include "imgui_impl_opengl3.h"
 
-ContextGL::ContextGL(BACKENDTYPE backendType) : mWindow(nullptr) {
+namespace {
+
+// Indexed by UNIFORMBINDING.
+const char *const kUniformBlockNames[] = {
+    "LightWorldPositionUniform", "LightUniforms",      "FogUniforms",
+    "LightFactorUniforms",       "FishVertexUniforms", "InnerUniforms"};
+
+}  // namespace
+
+ContextGL::ContextGL(BACKENDTYPE backendType)
+    : mWindow(nullptr),
+      mProgramCache(nullptr),
+      mHeadless(false),
+#ifdef ENABLE_OPENGL_HEADLESS
+      mHeadlessDisplay(EGL_NO_DISPLAY),
+      mHeadlessContext(EGL_NO_CONTEXT),
+      mFramebuffer(0),
+      mColorRenderbuffer(0),
+      mDepthStencilRenderbuffer(0),
+      mFrameFence(nullptr),
+#endif
+      mEnableUniformBuffers(false),
+      mGlobalUniformBuffers(),
+      mEnableInstancedFish(false),
+      mFishPers(nullptr),
+      mFishPersBuffer(0),
+      mCurrentProgram(0),
+      mCurrentUniforms(nullptr),
+      mCurrentVAO(0),
+      mCurrentVertexArray(nullptr),
+      mArrayBuffer(0),
+      mUniformBuffers(),
+      mActiveTextureUnit(0),
+      mBoundTextures(),
+      mBlendEnabled(-1),
+      mStateCacheCounters() {
   initAvailableToggleBitset(backendType);
 }
 
 ContextGL::~ContextGL() {
+  for (unsigned int buffer : mGlobalUniformBuffers) {
+    if (buffer != 0) {
+      deleteUniformBuffer(buffer);
+    }
+  }
+  if (mFishPersBuffer != 0) {
+    deleteBuffer(mFishPersBuffer);
+  }
+  delete[] mFishPers;
+  delete mProgramCache;
   delete mResourceHelper;
   if (!mDisableControlPanel) {
     destoryImgUI();
   }
 
+#ifdef ENABLE_OPENGL_HEADLESS
+  if (mHeadless) {
+    if (mFrameFence != nullptr) {
+      glDeleteSync(mFrameFence);
+    }
+    glDeleteRenderbuffers(1, &mColorRenderbuffer);
+    glDeleteRenderbuffers(1, &mDepthStencilRenderbuffer);
+    glDeleteFramebuffers(1, &mFramebuffer);
+    eglMakeCurrent(mHeadlessDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                   EGL_NO_CONTEXT);
+    eglDestroyContext(mHeadlessDisplay, mHeadlessContext);
+    eglTerminate(mHeadlessDisplay);
+    return;
+  }
+#endif
+
   glfwTerminate();
 }
 
@@ -52,6 +116,12 @@ bool ContextGL::initialize(
     const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset,
     int windowWidth,
     int windowHeight) {
+#ifdef ENABLE_OPENGL_HEADLESS
+  if (toggleBitset.test(static_cast<size_t>(TOGGLE::HEADLESS))) {
+    return initializeHeadless(backend, windowWidth, windowHeight);
+  }
+#endif
+
   // initialise GLFW
   if (!glfwInit()) {
     std::cout << "Failed to initialise GLFW" << std::endl;
@@ -71,6 +141,8 @@ bool ContextGL::initialize(
       (toggleBitset.test(static_cast<TOGGLE>(TOGGLE::DISABLECONTROLPANEL)));
 
   mResourceHelper = new ResourceHelper("opengl", "450", backend);
+  mEnableUniformBuffers = true;
+  mEnableInstancedFish = true;
 
 #if defined(OS_MAC)
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -241,13 +313,155 @@ bool ContextGL::initialize(
     ImGui_ImplOpenGL3_Init(mGLSLVersion.c_str());
   }
 
+  initDriverInfo();
+
+  return true;
+}
+
+#ifdef ENABLE_OPENGL_HEADLESS
+// A surfaceless context needs neither a window nor a display server, so it
+// runs on gpu-less hosts by software rasterizers such as Mesa llvmpipe.
+bool ContextGL::initializeHeadless(BACKENDTYPE backend,
+                                   int windowWidth,
+                                   int windowHeight) {
+  mHeadless = true;
+  mDisableControlPanel = true;
+  mResourceHelper = new ResourceHelper("opengl", "450", backend);
+  mEnableUniformBuffers = true;
+  mEnableInstancedFish = true;
+  mGLSLVersion = "#version 450";
+
+  mClientWidth = kHeadlessWidth;
+  mClientHeight = kHeadlessHeight;
+  setWindowSize(windowWidth, windowHeight);
+
+  // Prefer the surfaceless platform of Mesa, the default display may try to
+  // connect to a display server.
+  const char *clientExtensions =
+      eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+          eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (clientExtensions != nullptr && getPlatformDisplay != nullptr &&
+      strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+    mHeadlessDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                          EGL_DEFAULT_DISPLAY, nullptr);
+  } else {
+    mHeadlessDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+
+  EGLint majorVersion = 0;
+  EGLint minorVersion = 0;
+  if (mHeadlessDisplay == EGL_NO_DISPLAY ||
+      eglInitialize(mHeadlessDisplay, &majorVersion, &minorVersion) ==
+          EGL_FALSE) {
+    std::cerr << "Failed to initialize EGL display." << std::endl;
+    return false;
+  }
+
+  const char *displayExtensions =
+      eglQueryString(mHeadlessDisplay, EGL_EXTENSIONS);
+  if (strstr(displayExtensions, "EGL_KHR_surfaceless_context") == nullptr ||
+      strstr(displayExtensions, "EGL_KHR_create_context") == nullptr) {
+    std::cerr << "Surfaceless EGL context isn't supported." << std::endl;
+    return false;
+  }
+
+  const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                     EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                     EGL_NONE};
+  EGLConfig config;
+  EGLint configCount = 0;
+  if (eglChooseConfig(mHeadlessDisplay, configAttributes, &config, 1,
+                      &configCount) == EGL_FALSE ||
+      configCount == 0) {
+    std::cerr << "Could not find a suitable EGL config." << std::endl;
+    return false;
+  }
+
+  const EGLint contextAttributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION_KHR,
+      4,
+      EGL_CONTEXT_MINOR_VERSION_KHR,
+      5,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR,
+      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+      EGL_NONE};
+  eglBindAPI(EGL_OPENGL_API);
+  mHeadlessContext = eglCreateContext(mHeadlessDisplay, config,
+                                      EGL_NO_CONTEXT, contextAttributes);
+  if (mHeadlessContext == EGL_NO_CONTEXT ||
+      eglMakeCurrent(mHeadlessDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                     mHeadlessContext) == EGL_FALSE) {
+    std::cerr << "Failed to create OpenGL 4.5 context." << std::endl;
+    return false;
+  }
+
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+    std::cerr << "Failed to load OpenGL functions." << std::endl;
+    return false;
+  }
+
+  // The framebuffer object stands in for the default framebuffer, and stays
+  // bound all the time.
+  int samples = mMSAASampleCount > 1 ? mMSAASampleCount : 0;
+  glGenFramebuffers(1, &mFramebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+  glGenRenderbuffers(1, &mColorRenderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, mColorRenderbuffer);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8,
+                                   mClientWidth, mClientHeight);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, mColorRenderbuffer);
+  glGenRenderbuffers(1, &mDepthStencilRenderbuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, mDepthStencilRenderbuffer);
+  glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+                                   GL_DEPTH24_STENCIL8, mClientWidth,
+                                   mClientHeight);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, mDepthStencilRenderbuffer);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "Offscreen framebuffer is incomplete." << std::endl;
+    return false;
+  }
+  glViewport(0, 0, mClientWidth, mClientHeight);
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+
+  initDriverInfo();
+
+  return true;
+}
+#endif
+
+void ContextGL::initDriverInfo() {
   std::string renderer((const char *)glGetString(GL_RENDERER));
   size_t index = renderer.find("/");
   renderer = renderer.substr(0, index);
   std::cout << renderer << std::endl;
   mResourceHelper->setRenderer(renderer);
 
-  return true;
+  initProgramCache();
+}
+
+// Program binaries are only valid for the driver that produced them, so the
+// full vendor, renderer and version strings are part of the cache key.
+void ContextGL::initProgramCache() {
+  GLint formatCount = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+  // Drop the error of contexts that don't know the query.
+  while (glGetError() != GL_NO_ERROR) {
+  }
+  if (formatCount <= 0 || !mResourceHelper->createCacheFolder()) {
+    return;
+  }
+
+  std::ostringstream driverStream;
+  driverStream << glGetString(GL_VENDOR) << "\n"
+               << glGetString(GL_RENDERER) << "\n"
+               << glGetString(GL_VERSION);
+  mDriverString = driverStream.str();
+  mProgramCache = new BlobCache(mResourceHelper->getCachePath(), "glprogram-");
 }
 
 #ifdef GL_GLEXT_PROTOTYPES
@@ -335,16 +549,12 @@ void ContextGL::framebufferResizeCallback(GLFWwindow *window,
 
 Texture *ContextGL::createTexture(const std::string &name,
                                   const std::string &url) {
-  TextureGL *texture = new TextureGL(this, name, url);
-  texture->loadTexture();
-  return texture;
+  return new TextureGL(this, name, url);
 }
 
 Texture *ContextGL::createTexture(const std::string &name,
                                   const std::vector<std::string> &urls) {
-  TextureGL *texture = new TextureGL(this, name, urls);
-  texture->loadTexture();
-  return texture;
+  return new TextureGL(this, name, urls);
 }
 
 unsigned int ContextGL::generateTexture() {
@@ -354,20 +564,30 @@ unsigned int ContextGL::generateTexture() {
 }
 
 void ContextGL::bindTexture(unsigned int target, unsigned int textureId) {
-  glBindTexture(target, textureId);
+  bindTextureUnit(mActiveTextureUnit, target, textureId);
 }
 
 void ContextGL::deleteTexture(unsigned int texture) {
   glDeleteTextures(1, &texture);
+
+  // Deleting a texture unbinds it from all of the units.
+  for (auto &unitTextures : mBoundTextures) {
+    for (unsigned int &boundTexture : unitTextures) {
+      if (boundTexture == texture) {
+        boundTexture = 0;
+      }
+    }
+  }
 }
 
 void ContextGL::uploadTexture(unsigned int target,
                               unsigned int format,
+                              int level,
                               int width,
                               int height,
-                              unsigned char *pixels) {
-  glTexImage2D(target, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE,
-               pixels);
+                              const unsigned char *pixels) {
+  glTexImage2D(target, level, format, width, height, 0, format,
+               GL_UNSIGNED_BYTE, pixels);
   ASSERT(glGetError() == GL_NO_ERROR);
 }
 
@@ -377,8 +597,124 @@ void ContextGL::setParameter(unsigned int target,
   glTexParameteri(target, pname, param);
 }
 
-void ContextGL::generateMipmap(unsigned int target) {
-  glGenerateMipmap(target);
+void ContextGL::initGeneralResources(Aquarium *aquarium) {
+  if (mEnableUniformBuffers) {
+    // Light and fog don't change, light position is updated every frame.
+    mGlobalUniformBuffers[LIGHTWORLDPOSITIONBINDING] =
+        createUniformBuffer(nullptr, sizeof(LightWorldPositionUniform));
+    mGlobalUniformBuffers[LIGHTBINDING] = createUniformBuffer(
+        &aquarium->lightUniforms, sizeof(aquarium->lightUniforms));
+    mGlobalUniformBuffers[FOGBINDING] = createUniformBuffer(
+        &aquarium->fogUniforms, sizeof(aquarium->fogUniforms));
+    bindUniformBuffer(LIGHTWORLDPOSITIONBINDING,
+                      mGlobalUniformBuffers[LIGHTWORLDPOSITIONBINDING]);
+    bindUniformBuffer(LIGHTBINDING, mGlobalUniformBuffers[LIGHTBINDING]);
+    bindUniformBuffer(FOGBINDING, mGlobalUniformBuffers[FOGBINDING]);
+  }
+
+  reallocResource(aquarium->getPreFishCount(), aquarium->getCurFishCount(),
+                  false);
+}
+
+// Orphan the buffer on update, so that the driver doesn't wait for draws of
+// the last frame to finish.
+void ContextGL::updateWorldlUniforms(Aquarium *aquarium) {
+  if (!mEnableUniformBuffers) {
+    return;
+  }
+
+  glBindBuffer(GL_UNIFORM_BUFFER,
+               mGlobalUniformBuffers[LIGHTWORLDPOSITIONBINDING]);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(LightWorldPositionUniform),
+               &aquarium->lightWorldPositionUniform, GL_STREAM_DRAW);
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
+unsigned int ContextGL::createUniformBuffer(const void *data,
+                                            size_t size) const {
+  unsigned int buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, size, data,
+               data == nullptr ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+  return buffer;
+}
+
+void ContextGL::deleteUniformBuffer(unsigned int buffer) const {
+  glDeleteBuffers(1, &buffer);
+
+  // Deleting a buffer unbinds it from all of the binding points.
+  for (unsigned int &boundBuffer : mUniformBuffers) {
+    if (boundBuffer == buffer) {
+      boundBuffer = 0;
+    }
+  }
+}
+
+void ContextGL::bindUniformBuffer(UNIFORMBINDING binding,
+                                  unsigned int buffer) const {
+  countStateChange(mUniformBuffers[binding] == buffer);
+  if (mUniformBuffers[binding] == buffer) {
+    return;
+  }
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+  mUniformBuffers[binding] = buffer;
+}
+
+// Block bindings can't be set in 410 shaders, and aren't kept by program
+// binaries on all drivers, so they are set after every link.
+void ContextGL::bindUniformBlocks(unsigned int programId) {
+  if (!mEnableUniformBuffers) {
+    return;
+  }
+
+  for (int binding = 0; binding < UNIFORMBINDINGMAX; ++binding) {
+    GLuint index =
+        glGetUniformBlockIndex(programId, kUniformBlockNames[binding]);
+    if (index != GL_INVALID_INDEX) {
+      glUniformBlockBinding(programId, index, binding);
+    }
+  }
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
+void ContextGL::reallocResource(int preTotalInstance,
+                                int curTotalInstance,
+                                bool enableDynamicBufferOffset) {
+  if (!mEnableInstancedFish) {
+    return;
+  }
+
+  // Allocate even if there is no fish yet, so that fish models always find
+  // the FishPer array in the instanced path.
+  mPreTotalInstance = preTotalInstance;
+  mCurTotalInstance = curTotalInstance;
+  if (mFishCapacity.grow(curTotalInstance) || mFishPers == nullptr) {
+    allocateFishResource();
+  }
+}
+
+// Contents of the FishPer buffer are rewritten every frame, so they aren't
+// kept across reallocation.
+void ContextGL::allocateFishResource() {
+  int capacity = mFishCapacity.getCapacity();
+
+  delete[] mFishPers;
+  mFishPers = new FishPer[capacity];
+
+  if (mFishPersBuffer == 0) {
+    mFishPersBuffer = generateBuffer();
+  }
+  bindArrayBuffer(mFishPersBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(FishPer) * capacity, nullptr,
+               GL_STREAM_DRAW);
+
+  ASSERT(glGetError() == GL_NO_ERROR);
 }
 
 void ContextGL::updateAllFishData() {
@@ -393,25 +729,29 @@ void ContextGL::initState() {
 
 void ContextGL::initAvailableToggleBitset(BACKENDTYPE backendType) {
   mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::ENABLEFULLSCREENMODE));
+#ifdef ENABLE_OPENGL_HEADLESS
+  mAvailableToggleBitset.set(static_cast<size_t>(TOGGLE::HEADLESS));
+#endif
 }
 
 Buffer *ContextGL::createBuffer(int numComponents,
-                                std::vector<float> *buf,
+                                const float *buf,
+                                int totalComponents,
                                 bool isIndex) {
-  BufferGL *buffer = new BufferGL(this, static_cast<int>(buf->size()),
-                                  numComponents, isIndex, GL_FLOAT, false);
-  buffer->loadBuffer(*buf);
+  BufferGL *buffer = new BufferGL(this, totalComponents, numComponents,
+                                  isIndex, GL_FLOAT, false);
+  buffer->loadBuffer(buf);
 
   return buffer;
 }
 
 Buffer *ContextGL::createBuffer(int numComponents,
-                                std::vector<unsigned short> *buf,
+                                const unsigned short *buf,
+                                int totalComponents,
                                 bool isIndex) {
-  BufferGL *buffer =
-      new BufferGL(this, static_cast<int>(buf->size()), numComponents, isIndex,
-                   GL_UNSIGNED_SHORT, true);
-  buffer->loadBuffer(*buf);
+  BufferGL *buffer = new BufferGL(this, totalComponents, numComponents,
+                                  isIndex, GL_UNSIGNED_SHORT, true);
+  buffer->loadBuffer(buf);
 
   return buffer;
 }
@@ -424,25 +764,51 @@ Program *ContextGL::createProgram(const std::string &mVId,
 }
 
 void ContextGL::setWindowTitle(const std::string &text) {
+  if (mHeadless) {
+    return;
+  }
   glfwSetWindowTitle(mWindow, text.c_str());
 }
 
 bool ContextGL::ShouldQuit() {
+  if (mHeadless) {
+    return false;
+  }
   return glfwWindowShouldClose(mWindow);
 }
 
 void ContextGL::KeyBoardQuit() {
+  if (mHeadless) {
+    return;
+  }
   if (glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     glfwSetWindowShouldClose(mWindow, GLFW_TRUE);
 }
 
 void ContextGL::DoFlush(
     const std::bitset<static_cast<size_t>(TOGGLE::TOGGLEMAX)> &toggleBitset) {
+  TRACE_SCOPE("DoFlush");
+#ifdef ENABLE_OPENGL_HEADLESS
+  if (mHeadless) {
+    GLsync lastFrameFence = mFrameFence;
+    mFrameFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (lastFrameFence != nullptr) {
+      glClientWaitSync(lastFrameFence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                       GL_TIMEOUT_IGNORED);
+      glDeleteSync(lastFrameFence);
+    }
+    return;
+  }
+#endif
+
+  {
+    TRACE_SCOPE("present");
 #ifdef GL_GLEXT_PROTOTYPES
-  eglSwapBuffers(mDisplay, mSurface);
+    eglSwapBuffers(mDisplay, mSurface);
 #else
-  glfwSwapBuffers(mWindow);
+    glfwSwapBuffers(mWindow);
 #endif
+  }
   glfwPollEvents();
 }
 
@@ -450,6 +816,9 @@ void ContextGL::Terminate() {
 }
 
 void ContextGL::showWindow() {
+  if (mHeadless) {
+    return;
+  }
   glfwGetFramebufferSize(mWindow, &mClientWidth, &mClientHeight);
   glViewport(0, 0, mClientWidth, mClientHeight);
   glfwShowWindow(mWindow);
@@ -492,6 +861,13 @@ int ContextGL::getAttribLocation(unsigned int programId,
 }
 
 void ContextGL::enableBlend(bool flag) const {
+  int enabled = flag ? 1 : 0;
+  countStateChange(mBlendEnabled == enabled);
+  if (mBlendEnabled == enabled) {
+    return;
+  }
+  mBlendEnabled = enabled;
+
   if (flag) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -509,6 +885,16 @@ void ContextGL::drawElements(const BufferGL &buffer) const {
   ASSERT(glGetError() == GL_NO_ERROR);
 }
 
+void ContextGL::drawElementsInstanced(const BufferGL &buffer,
+                                      int instanceCount) const {
+  GLint totalComponents = buffer.getTotalComponents();
+  GLenum type = buffer.getType();
+  glDrawElementsInstanced(GL_TRIANGLES, totalComponents, type, 0,
+                          instanceCount);
+
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
 Model *ContextGL::createModel(Aquarium *aquarium,
                               MODELGROUP type,
                               MODELNAME name,
@@ -539,6 +925,10 @@ Model *ContextGL::createModel(Aquarium *aquarium,
 }
 
 void ContextGL::preFrame() {
+  if (mEnableInstancedFish && mFishCapacity.shrink(mCurTotalInstance)) {
+    allocateFishResource();
+  }
+
   glClearColor(0, 0.8, 1, 0);
   glEnable(GL_DEPTH_TEST);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -548,6 +938,27 @@ void ContextGL::preFrame() {
 
 void ContextGL::setUniform(int index, const float *v, int type) const {
   ASSERT(index != -1);
+  int size;
+  switch (type) {
+  case GL_FLOAT_VEC4:
+    size = 4;
+    break;
+  case GL_FLOAT_VEC3:
+    size = 3;
+    break;
+  case GL_FLOAT_VEC2:
+    size = 2;
+    break;
+  case GL_FLOAT_MAT4:
+    size = 16;
+    break;
+  default:
+    size = 1;
+  }
+  if (!updateUniformCache(index, v, size)) {
+    return;
+  }
+
   switch (type) {
   case GL_FLOAT:
     {
@@ -587,27 +998,132 @@ void ContextGL::setTexture(const TextureGL &texture,
                            int index,
                            int unit) const {
   ASSERT(index != -1);
-  glUniform1i(index, unit);
-  glActiveTexture(GL_TEXTURE0 + unit);
-  glBindTexture(texture.getTarget(), texture.getTextureId());
+  // Samplers are shadowed with the other uniforms, small integers are exact
+  // in float.
+  float value = static_cast<float>(unit);
+  if (updateUniformCache(index, &value, 1)) {
+    glUniform1i(index, unit);
+  }
+  bindTextureUnit(unit, texture.getTarget(), texture.getTextureId());
 
   ASSERT(glGetError() == GL_NO_ERROR);
 }
 
+void ContextGL::bindTextureUnit(int unit,
+                                unsigned int target,
+                                unsigned int texture) const {
+  ASSERT(unit >= 0 && unit < kMaxTextureUnits);
+  unsigned int &boundTexture =
+      mBoundTextures[unit][target == GL_TEXTURE_CUBE_MAP ? 1 : 0];
+  countStateChange(boundTexture == texture);
+  if (boundTexture == texture) {
+    return;
+  }
+
+  if (mActiveTextureUnit != unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    mActiveTextureUnit = unit;
+  }
+  glBindTexture(target, texture);
+  boundTexture = texture;
+}
+
 void ContextGL::setAttribs(const BufferGL &bufferGL, int index) const {
   ASSERT(index != -1);
-  glBindBuffer(bufferGL.getTarget(), bufferGL.getBuffer());
+  VertexAttribState state;
+  state.buffer = bufferGL.getBuffer();
+  state.numComponents = bufferGL.getNumComponents();
+  state.type = bufferGL.getType();
+  state.normalize = bufferGL.getNormalize();
+  state.stride = bufferGL.getStride();
+  state.offset = bufferGL.getOffset();
+  state.divisor = 0;
+  setVertexAttrib(index, state);
+}
+
+// Attributes that are never set are disabled with a divisor of 0, which is
+// the initial state of a VAO.
+void ContextGL::setVertexAttrib(int index,
+                                const VertexAttribState &state) const {
+  VertexAttribState *current = nullptr;
+  if (mCurrentVertexArray != nullptr) {
+    std::vector<VertexAttribState> &attribs = mCurrentVertexArray->attribs;
+    if (attribs.size() <= static_cast<size_t>(index)) {
+      attribs.resize(index + 1, VertexAttribState());
+    }
+    current = &attribs[index];
+  }
+
+  bool redundant = current != nullptr && current->buffer == state.buffer &&
+                   current->numComponents == state.numComponents &&
+                   current->type == state.type &&
+                   current->normalize == state.normalize &&
+                   current->stride == state.stride &&
+                   current->offset == state.offset &&
+                   current->divisor == state.divisor;
+  countStateChange(redundant);
+  if (redundant) {
+    return;
+  }
+
+  bindArrayBuffer(state.buffer);
+  if (current == nullptr || current->buffer == 0) {
+    glEnableVertexAttribArray(index);
+  }
+  glVertexAttribPointer(index, state.numComponents, state.type,
+                        state.normalize, state.stride, state.offset);
+  if (current == nullptr || current->divisor != state.divisor) {
+    glVertexAttribDivisor(index, state.divisor);
+  }
+  if (current != nullptr) {
+    *current = state;
+  }
 
-  glEnableVertexAttribArray(index);
-  glVertexAttribPointer(index, bufferGL.getNumComponents(), bufferGL.getType(),
-                        bufferGL.getNormalize(), bufferGL.getStride(),
-                        bufferGL.getOffset());
+  ASSERT(glGetError() == GL_NO_ERROR);
+}
+
+void ContextGL::bindArrayBuffer(unsigned int buf) const {
+  if (mArrayBuffer != buf) {
+    glBindBuffer(GL_ARRAY_BUFFER, buf);
+    mArrayBuffer = buf;
+  }
+}
+
+void ContextGL::uploadFishPers(int begin, int count) const {
+  bindArrayBuffer(mFishPersBuffer);
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(FishPer) * begin,
+                  sizeof(FishPer) * count, mFishPers + begin);
 
   ASSERT(glGetError() == GL_NO_ERROR);
 }
 
+void ContextGL::setFishPerAttribs(int index,
+                                  int numComponents,
+                                  size_t offset) const {
+  ASSERT(index != -1);
+  VertexAttribState state;
+  state.buffer = mFishPersBuffer;
+  state.numComponents = numComponents;
+  state.type = GL_FLOAT;
+  state.normalize = false;
+  state.stride = sizeof(FishPer);
+  state.offset = reinterpret_cast<const void *>(offset);
+  state.divisor = 1;
+  setVertexAttrib(index, state);
+}
+
 void ContextGL::setIndices(const BufferGL &bufferGL) const {
+  bool redundant = mCurrentVertexArray != nullptr &&
+                   mCurrentVertexArray->elementBuffer == bufferGL.getBuffer();
+  countStateChange(redundant);
+  if (redundant) {
+    return;
+  }
+
   glBindBuffer(bufferGL.getTarget(), bufferGL.getBuffer());
+  if (mCurrentVertexArray != nullptr) {
+    mCurrentVertexArray->elementBuffer = bufferGL.getBuffer();
+  }
 }
 
 unsigned int ContextGL::generateVAO() {
@@ -617,11 +1133,25 @@ unsigned int ContextGL::generateVAO() {
 }
 
 void ContextGL::bindVAO(unsigned int vao) const {
+  countStateChange(mCurrentVertexArray != nullptr && mCurrentVAO == vao);
+  if (mCurrentVertexArray != nullptr && mCurrentVAO == vao) {
+    return;
+  }
+
   glBindVertexArray(vao);
+  mCurrentVAO = vao;
+  mCurrentVertexArray = &mVertexArrayCache[vao];
 }
 
 void ContextGL::deleteVAO(unsigned int mVAO) {
   glDeleteVertexArrays(1, &mVAO);
+
+  // Deleting the bound VAO binds VAO 0.
+  if (mCurrentVAO == mVAO) {
+    mCurrentVAO = 0;
+    mCurrentVertexArray = &mVertexArrayCache[0];
+  }
+  mVertexArrayCache.erase(mVAO);
 }
 
 unsigned int ContextGL::generateBuffer() {
@@ -632,24 +1162,46 @@ unsigned int ContextGL::generateBuffer() {
 
 void ContextGL::deleteBuffer(unsigned int buf) {
   glDeleteBuffers(1, &buf);
+
+  // The name may be reused by a new buffer, so forget every binding of it.
+  if (mArrayBuffer == buf) {
+    mArrayBuffer = 0;
+  }
+  for (auto &vertexArray : mVertexArrayCache) {
+    VertexArrayState &state = vertexArray.second;
+    if (state.elementBuffer == buf) {
+      state.elementBuffer = 0;
+    }
+    for (VertexAttribState &attrib : state.attribs) {
+      if (attrib.buffer == buf) {
+        attrib = VertexAttribState();
+      }
+    }
+  }
 }
 
 void ContextGL::bindBuffer(unsigned int target, unsigned int buf) {
+  if (target == GL_ARRAY_BUFFER) {
+    bindArrayBuffer(buf);
+    return;
+  }
+
   glBindBuffer(target, buf);
+  if (target == GL_ELEMENT_ARRAY_BUFFER && mCurrentVertexArray != nullptr) {
+    mCurrentVertexArray->elementBuffer = buf;
+  }
 }
 
-void ContextGL::uploadBuffer(unsigned int target,
-                             const std::vector<float> &buf) {
-  glBufferData(target, sizeof(GLfloat) * buf.size(), buf.data(),
-               GL_STATIC_DRAW);
+void ContextGL::uploadBuffer(unsigned int target, const float *buf, int size) {
+  glBufferData(target, sizeof(GLfloat) * size, buf, GL_STATIC_DRAW);
 
   ASSERT(glGetError() == GL_NO_ERROR);
 }
 
 void ContextGL::uploadBuffer(unsigned int target,
-                             const std::vector<unsigned short> &buf) {
-  glBufferData(target, sizeof(GLushort) * buf.size(), buf.data(),
-               GL_STATIC_DRAW);
+                             const unsigned short *buf,
+                             int size) {
+  glBufferData(target, sizeof(GLushort) * size, buf, GL_STATIC_DRAW);
 
   ASSERT(glGetError() == GL_NO_ERROR);
 }
@@ -659,16 +1211,95 @@ unsigned int ContextGL::generateProgram() {
 }
 
 void ContextGL::setProgram(unsigned int program) {
+  countStateChange(mCurrentUniforms != nullptr && mCurrentProgram == program);
+  if (mCurrentUniforms != nullptr && mCurrentProgram == program) {
+    return;
+  }
+
   glUseProgram(program);
+  mCurrentProgram = program;
+  mCurrentUniforms = &mUniformCache[program];
 }
 
 void ContextGL::deleteProgram(unsigned int program) {
   glDeleteProgram(program);
+
+  if (mCurrentProgram == program) {
+    mCurrentProgram = 0;
+    mCurrentUniforms = nullptr;
+  }
+  mUniformCache.erase(program);
+}
+
+// Return true if the uniform of the current program has to be set to v.
+// Uniforms that aren't active have location -1, which GL ignores, so they are
+// skipped.
+bool ContextGL::updateUniformCache(int index,
+                                   const float *v,
+                                   int size) const {
+  if (index < 0) {
+    return false;
+  }
+
+  if (mCurrentUniforms == nullptr) {
+    countStateChange(false);
+    return true;
+  }
+
+  UniformValue &value = (*mCurrentUniforms)[index];
+  bool redundant =
+      value.size == size && memcmp(value.data, v, sizeof(float) * size) == 0;
+  countStateChange(redundant);
+  if (redundant) {
+    return false;
+  }
+
+  value.size = size;
+  memcpy(value.data, v, sizeof(float) * size);
+  return true;
 }
 
+void ContextGL::countStateChange(bool redundant) const {
+  if (redundant) {
+    ++mStateCacheCounters.hits;
+  } else {
+    ++mStateCacheCounters.misses;
+  }
+}
+
+void ContextGL::resetStateCacheCounters() {
+  mStateCacheCounters = StateCacheCounters();
+}
+
+void ContextGL::renderImguiStats() {
+  uint64_t total = mStateCacheCounters.hits + mStateCacheCounters.misses;
+  ImGui::Text("STATE CACHE: %.1f%% of %llu state changes skipped",
+              total == 0 ? 0.0 : 100.0 * mStateCacheCounters.hits / total,
+              static_cast<unsigned long long>(total));
+}
+
+// Compile flags are substituted into the sources by ProgramGL, so the sources
+// cover them in the program cache key.
 bool ContextGL::compileProgram(unsigned int programId,
                                const std::string &VertexShaderCode,
                                const std::string &FragmentShaderCode) {
+  // Linking resets uniforms of the program.
+  auto uniforms = mUniformCache.find(programId);
+  if (uniforms != mUniformCache.end()) {
+    uniforms->second.clear();
+  }
+
+  std::string key;
+  if (mProgramCache != nullptr) {
+    key = mDriverString + "\n" + VertexShaderCode + "\n" + FragmentShaderCode;
+    if (loadProgramBinary(programId, key)) {
+      bindUniformBlocks(programId);
+      return true;
+    }
+    glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                        GL_TRUE);
+  }
+
   // Create the shaders
   GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
   GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
@@ -723,5 +1354,54 @@ bool ContextGL::compileProgram(unsigned int programId,
   glDeleteShader(VertexShaderID);
   glDeleteShader(FragmentShaderID);
 
+  if (Result && mProgramCache != nullptr) {
+    storeProgramBinary(programId, key);
+  }
+  bindUniformBlocks(programId);
+
   return true;
 }
+
+// A cached binary is rejected by the driver, and the program is compiled
+// again, if the driver changed in a way the key doesn't catch.
+bool ContextGL::loadProgramBinary(unsigned int programId,
+                                  const std::string &key) {
+  std::vector<char> blob;
+  if (!mProgramCache->load(key, &blob) || blob.size() <= sizeof(GLenum)) {
+    return false;
+  }
+
+  GLenum format;
+  memcpy(&format, blob.data(), sizeof(format));
+  glProgramBinary(programId, format, blob.data() + sizeof(format),
+                  static_cast<GLsizei>(blob.size() - sizeof(format)));
+  GLint linked = GL_FALSE;
+  glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+  while (glGetError() != GL_NO_ERROR) {
+  }
+  return linked == GL_TRUE;
+}
+
+void ContextGL::storeProgramBinary(unsigned int programId,
+                                   const std::string &key) {
+  GLint length = 0;
+  glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+
+  std::vector<char> blob(sizeof(GLenum) + length);
+  GLenum format;
+  GLsizei written = 0;
+  glGetProgramBinary(programId, length, &written, &format,
+                     blob.data() + sizeof(GLenum));
+  if (written <= 0) {
+    return;
+  }
+  memcpy(blob.data(), &format, sizeof(format));
+  blob.resize(sizeof(GLenum) + written);
+
+  if (!mProgramCache->store(key, blob.data(), blob.size())) {
+    std::cerr << "Failed to write program cache." << std::endl;
+  }
+}
@@ -8,6 +8,8 @@
 #ifndef CONTEXTGL_H
 #define CONTEXTGL_H
 
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 #define GLFW_INCLUDE_NONE
@@ -25,12 +27,43 @@
 #include "glad/glad.h"
 #endif
 
+#ifdef ENABLE_OPENGL_HEADLESS
+// There is no display server in headless mode, don't pull in X11.
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+// egl.h defines it, while it marks ANGLE builds in the code.
+#undef EGL_EGL_PROTOTYPES
+#endif
+
 #include "../Aquarium.h"
 #include "../Context.h"
+#include "../InstanceCapacity.h"
 
+class BlobCache;
 class BufferGL;
 class TextureGL;
 
+// Binding points of the uniform blocks of 450 shaders. Blocks are named after
+// the uniform structures of Dawn shaders.
+enum UNIFORMBINDING : short {
+  LIGHTWORLDPOSITIONBINDING,
+  LIGHTBINDING,
+  FOGBINDING,
+  LIGHTFACTORBINDING,
+  FISHVERTEXBINDING,
+  INNERBINDING,
+  UNIFORMBINDINGMAX
+};
+
+// A hit is a state change skipped because the state is already set, a miss
+// is a state change sent to the driver.
+struct StateCacheCounters {
+  uint64_t hits;
+  uint64_t misses;
+};
+
 class ContextGL : public Context {
 public:
   static ContextGL *create(BACKENDTYPE backendType);
@@ -58,6 +91,23 @@ public:
   void preFrame() override;
   void enableBlend(bool flag) const;
 
+  // Global and per model uniforms are kept in std140 uniform buffers, and only
+  // per instance uniforms are set one by one. It's disabled on ANGLE, whose
+  // shaders don't have uniform blocks.
+  bool isUniformBufferEnabled() const { return mEnableUniformBuffers; }
+  // Uniform buffers of models are static, and deleted by the models.
+  unsigned int createUniformBuffer(const void *data, size_t size) const;
+  void deleteUniformBuffer(unsigned int buffer) const;
+  void bindUniformBuffer(UNIFORMBINDING binding, unsigned int buffer) const;
+  unsigned int getGlobalUniformBuffer(UNIFORMBINDING binding) const {
+    return mGlobalUniformBuffers[binding];
+  }
+
+  const StateCacheCounters &getStateCacheCounters() const {
+    return mStateCacheCounters;
+  }
+  void resetStateCacheCounters();
+
   Model *createModel(Aquarium *aquarium,
                      MODELGROUP type,
                      MODELNAME name,
@@ -69,19 +119,31 @@ public:
   void setAttribs(const BufferGL &bufferGL, int index) const;
   void setIndices(const BufferGL &bufferGL) const;
   void drawElements(const BufferGL &buffer) const;
+  void drawElementsInstanced(const BufferGL &buffer, int instanceCount) const;
+
+  // Fish models draw their fishes by one instanced draw, reading FishPer of
+  // all fishes as per instance attributes. It's disabled on ANGLE, whose
+  // shaders take FishPer as uniforms.
+  bool isInstancedFishEnabled() const { return mEnableInstancedFish; }
+  FishPer *getFishPers() const { return mFishPers; }
+  void uploadFishPers(int begin, int count) const;
+  // Point the attribute at a member of FishPer, offset is in bytes from the
+  // beginning of the FishPer buffer.
+  void setFishPerAttribs(int index, int numComponents, size_t offset) const;
 
   Buffer *createBuffer(int numComponents,
-                       std::vector<float> *buffer,
+                       const float *buffer,
+                       int totalComponents,
                        bool isIndex) override;
   Buffer *createBuffer(int numComponents,
-                       std::vector<unsigned short> *buffer,
+                       const unsigned short *buffer,
+                       int totalComponents,
                        bool isIndex) override;
   unsigned int generateBuffer();
   void deleteBuffer(unsigned int buf);
   void bindBuffer(unsigned int target, unsigned int buf);
-  void uploadBuffer(unsigned int target, const std::vector<float> &buf);
-  void uploadBuffer(unsigned int target,
-                    const std::vector<unsigned short> &buf);
+  void uploadBuffer(unsigned int target, const float *buf, int size);
+  void uploadBuffer(unsigned int target, const unsigned short *buf, int size);
 
   Program *createProgram(const std::string &mVId,
                          const std::string &mFId) override;
@@ -104,19 +166,63 @@ public:
   void deleteTexture(unsigned int texture);
   void uploadTexture(unsigned int target,
                      unsigned int format,
+                     int level,
                      int width,
                      int height,
-                     unsigned char *pixel);
+                     const unsigned char *pixel);
   void setParameter(unsigned int target, unsigned int pname, int param);
-  void generateMipmap(unsigned int target);
+  void initGeneralResources(Aquarium *aquarium) override;
+  void updateWorldlUniforms(Aquarium *aquarium) override;
+  void reallocResource(int preTotalInstance,
+                       int curTotalInstance,
+                       bool enableDynamicBufferOffset) override;
   void updateAllFishData() override;
 
 protected:
   explicit ContextGL(BACKENDTYPE backendType);
 
+  void renderImguiStats() override;
+
 private:
+  // Bound textures are shadowed for units below it.
+  static constexpr int kMaxTextureUnits = 16;
+
+  struct UniformValue {
+    // Number of floats of the value, or 0 if it isn't known.
+    int size;
+    float data[16];
+  };
+
+  struct VertexAttribState {
+    unsigned int buffer;
+    int numComponents;
+    unsigned int type;
+    bool normalize;
+    int stride;
+    const void *offset;
+    int divisor;
+  };
+
+  struct VertexArrayState {
+    unsigned int elementBuffer;
+    std::vector<VertexAttribState> attribs;
+  };
+
+  bool updateUniformCache(int index, const float *v, int size) const;
+  void setVertexAttrib(int index, const VertexAttribState &state) const;
+  void bindArrayBuffer(unsigned int buf) const;
+  void bindTextureUnit(int unit,
+                       unsigned int target,
+                       unsigned int texture) const;
+  void countStateChange(bool redundant) const;
   void initState();
   void initAvailableToggleBitset(BACKENDTYPE backendType) override;
+  void initDriverInfo();
+  void initProgramCache();
+  void bindUniformBlocks(unsigned int programId);
+  void allocateFishResource();
+  bool loadProgramBinary(unsigned int programId, const std::string &key);
+  void storeProgramBinary(unsigned int programId, const std::string &key);
   static void framebufferResizeCallback(GLFWwindow *window,
                                         int width,
                                         int height);
@@ -124,6 +230,61 @@ private:
   GLFWwindow *mWindow;
   std::string mGLSLVersion;
 
+  // Linked program binaries keyed on the driver and shader sources. It's null
+  // if the driver doesn't support program binaries.
+  BlobCache *mProgramCache;
+  std::string mDriverString;
+
+  // Headless mode renders into a framebuffer object of a surfaceless EGL
+  // context instead of a window.
+  bool mHeadless;
+#ifdef ENABLE_OPENGL_HEADLESS
+  bool initializeHeadless(BACKENDTYPE backend,
+                          int windowWidth,
+                          int windowHeight);
+
+  EGLDisplay mHeadlessDisplay;
+  EGLContext mHeadlessContext;
+  unsigned int mFramebuffer;
+  unsigned int mColorRenderbuffer;
+  unsigned int mDepthStencilRenderbuffer;
+  // Fence of the last frame, which throttles rendering like swapping buffers
+  // does.
+  GLsync mFrameFence;
+#endif
+
+  bool mEnableUniformBuffers;
+  // Buffers of LightWorldPositionUniform, LightUniforms and FogUniforms,
+  // other bindings are 0.
+  unsigned int mGlobalUniformBuffers[UNIFORMBINDINGMAX];
+
+  bool mEnableInstancedFish;
+  FishPer *mFishPers;
+  unsigned int mFishPersBuffer;
+  InstanceCapacity mFishCapacity;
+
+  // Shadow of the GL state, so that redundant state changes are skipped. The
+  // state is only changed through ContextGL, except by imgui, which restores
+  // it after rendering. Uniform values are kept per program and vertex
+  // attributes per VAO, the same as GL does. Uniform locations are chosen by
+  // the driver and may be sparse, so values are keyed by location.
+  mutable unsigned int mCurrentProgram;
+  mutable std::unordered_map<unsigned int,
+                             std::unordered_map<int, UniformValue>>
+      mUniformCache;
+  mutable std::unordered_map<int, UniformValue> *mCurrentUniforms;
+  mutable unsigned int mCurrentVAO;
+  mutable std::unordered_map<unsigned int, VertexArrayState> mVertexArrayCache;
+  mutable VertexArrayState *mCurrentVertexArray;
+  mutable unsigned int mArrayBuffer;
+  mutable unsigned int mUniformBuffers[UNIFORMBINDINGMAX];
+  mutable int mActiveTextureUnit;
+  // Textures bound to GL_TEXTURE_2D and GL_TEXTURE_CUBE_MAP of each unit.
+  mutable unsigned int mBoundTextures[kMaxTextureUnits][2];
+  // -1 if blending isn't known yet.
+  mutable int mBlendEnabled;
+  mutable StateCacheCounters mStateCacheCounters;
+
 #ifdef EGL_EGL_PROTOTYPES
   EGLBoolean FindEGLConfig(EGLDisplay dpy,
                            const EGLint *attrib_list,
@@ -7,6 +7,8 @@
 
 #include "FishModelGL.h"
 
+#include <cstddef>
+
 #include "ContextGL.h"
 #include "ProgramGL.h"
 
@@ -15,7 +17,10 @@ FishModelGL::FishModelGL(const ContextGL *mContextGL,
                          MODELGROUP type,
                          MODELNAME name,
                          bool blend)
-    : FishModel(type, name, blend, aquarium), mContextGL(mContextGL) {
+    : FishModel(type, name, blend, aquarium),
+      mContextGL(mContextGL),
+      mLightFactorBuffer(0),
+      mFishVertexBuffer(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -39,6 +44,15 @@ FishModelGL::FishModelGL(const ContextGL *mContextGL,
   mFishWaveLengthUniform.first = fishInfo.fishWaveLength;
 }
 
+FishModelGL::~FishModelGL() {
+  if (mLightFactorBuffer != 0) {
+    mContextGL->deleteUniformBuffer(mLightFactorBuffer);
+  }
+  if (mFishVertexBuffer != 0) {
+    mContextGL->deleteUniformBuffer(mFishVertexBuffer);
+  }
+}
+
 void FishModelGL::init() {
   ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
   mViewInverseUniform.second =
@@ -74,14 +88,26 @@ void FishModelGL::init() {
   mFishBendAmountUniform.second = mContextGL->getUniformLocation(
       programGL->getProgramId(), "fishBendAmount");
 
-  mWorldPositionUniform.second = mContextGL->getUniformLocation(
-      programGL->getProgramId(), "worldPosition");
-  mNextPositionUniform.second =
-      mContextGL->getUniformLocation(programGL->getProgramId(), "nextPosition");
-  mScaleUniform.second =
-      mContextGL->getUniformLocation(programGL->getProgramId(), "scale");
-  mTimeUniform.second =
-      mContextGL->getUniformLocation(programGL->getProgramId(), "time");
+  // Shaders of the instanced path take FishPer as attributes.
+  if (mContextGL->isInstancedFishEnabled()) {
+    mWorldPositionAttrib = mContextGL->getAttribLocation(
+        programGL->getProgramId(), "worldPosition");
+    mScaleAttrib =
+        mContextGL->getAttribLocation(programGL->getProgramId(), "scale");
+    mNextPositionAttrib = mContextGL->getAttribLocation(
+        programGL->getProgramId(), "nextPosition");
+    mTimeAttrib =
+        mContextGL->getAttribLocation(programGL->getProgramId(), "time");
+  } else {
+    mWorldPositionUniform.second = mContextGL->getUniformLocation(
+        programGL->getProgramId(), "worldPosition");
+    mNextPositionUniform.second = mContextGL->getUniformLocation(
+        programGL->getProgramId(), "nextPosition");
+    mScaleUniform.second =
+        mContextGL->getUniformLocation(programGL->getProgramId(), "scale");
+    mTimeUniform.second =
+        mContextGL->getUniformLocation(programGL->getProgramId(), "time");
+  }
 
   mDiffuseTexture.first = static_cast<TextureGL *>(textureMap["diffuse"]);
   mDiffuseTexture.second =
@@ -114,13 +140,41 @@ void FishModelGL::init() {
       mContextGL->getAttribLocation(programGL->getProgramId(), "binormal");
 
   mIndicesBuffer = static_cast<BufferGL *>(bufferMap["indices"]);
+
+  if (mContextGL->isUniformBufferEnabled()) {
+    LightFactorUniforms lightFactorUniforms = {mShininessUniform.first,
+                                               mSpecularFactorUniform.first};
+    mLightFactorBuffer = mContextGL->createUniformBuffer(
+        &lightFactorUniforms, sizeof(lightFactorUniforms));
+    FishVertexUniforms fishVertexUniforms = {mFishLengthUniform.first,
+                                             mFishWaveLengthUniform.first,
+                                             mFishBendAmountUniform.first};
+    mFishVertexBuffer = mContextGL->createUniformBuffer(
+        &fishVertexUniforms, sizeof(fishVertexUniforms));
+  }
 }
 
 void FishModelGL::draw() {
+  if (mContextGL->isInstancedFishEnabled()) {
+    if (mCurInstance > 0) {
+      mContextGL->drawElementsInstanced(*mIndicesBuffer, mCurInstance);
+    }
+    return;
+  }
+
   mContextGL->drawElements(*mIndicesBuffer);
 }
 
+FishPer *FishModelGL::getFishPers() {
+  if (!mContextGL->isInstancedFishEnabled()) {
+    return nullptr;
+  }
+  return mContextGL->getFishPers() + mFishPerOffset;
+}
+
 void FishModelGL::prepareForDraw() {
+  updateInstanceRange();
+
   mProgram->setProgram();
   mContextGL->enableBlend(mBlend);
 
@@ -136,6 +190,30 @@ void FishModelGL::prepareForDraw() {
 
   mContextGL->setIndices(*mIndicesBuffer);
 
+  if (mContextGL->isUniformBufferEnabled()) {
+    mContextGL->bindUniformBuffer(UNIFORMBINDING::LIGHTFACTORBINDING,
+                                  mLightFactorBuffer);
+    mContextGL->bindUniformBuffer(UNIFORMBINDING::FISHVERTEXBINDING,
+                                  mFishVertexBuffer);
+    mContextGL->bindUniformBuffer(
+        UNIFORMBINDING::FOGBINDING,
+        mContextGL->getGlobalUniformBuffer(UNIFORMBINDING::FOGBINDING));
+  } else {
+    setUniforms();
+  }
+
+  // Fish models includes small, medium and big. Some of them contains
+  // reflection and skybox texture, but some doesn't.
+  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
+  mContextGL->setTexture(*mNormalTexture.first, mNormalTexture.second, 1);
+  if (mSkyboxTexture.second != -1 && mReflectionTexture.second != -1) {
+    mContextGL->setTexture(*mReflectionTexture.first, mReflectionTexture.second,
+                           2);
+    mContextGL->setTexture(*mSkyboxTexture.first, mSkyboxTexture.second, 3);
+  }
+}
+
+void FishModelGL::setUniforms() {
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mLightWorldPosUniform.second,
@@ -167,20 +245,28 @@ void FishModelGL::prepareForDraw() {
                          GL_FLOAT);
   mContextGL->setUniform(mFishWaveLengthUniform.second,
                          &mFishWaveLengthUniform.first, GL_FLOAT);
-
-  // Fish models includes small, medium and big. Some of them contains
-  // reflection and skybox texture, but some doesn't.
-  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
-  mContextGL->setTexture(*mNormalTexture.first, mNormalTexture.second, 1);
-  if (mSkyboxTexture.second != -1 && mReflectionTexture.second != -1) {
-    mContextGL->setTexture(*mReflectionTexture.first, mReflectionTexture.second,
-                           2);
-    mContextGL->setTexture(*mSkyboxTexture.first, mSkyboxTexture.second, 3);
-  }
 }
 
 void FishModelGL::updatePerInstanceUniforms(
     const WorldUniforms &WorldUniforms) {
+  if (mContextGL->isInstancedFishEnabled()) {
+    if (mCurInstance == 0) {
+      return;
+    }
+
+    mContextGL->uploadFishPers(mFishPerOffset, mCurInstance);
+    size_t offset = sizeof(FishPer) * mFishPerOffset;
+    mContextGL->setFishPerAttribs(mWorldPositionAttrib, 3,
+                                  offset + offsetof(FishPer, worldPosition));
+    mContextGL->setFishPerAttribs(mScaleAttrib, 1,
+                                  offset + offsetof(FishPer, scale));
+    mContextGL->setFishPerAttribs(mNextPositionAttrib, 3,
+                                  offset + offsetof(FishPer, nextPosition));
+    mContextGL->setFishPerAttribs(mTimeAttrib, 1,
+                                  offset + offsetof(FishPer, time));
+    return;
+  }
+
   mContextGL->setUniform(mScaleUniform.second, &mScaleUniform.first, GL_FLOAT);
   mContextGL->setUniform(mTimeUniform.second, &mTimeUniform.first, GL_FLOAT);
   mContextGL->setUniform(mWorldPositionUniform.second,
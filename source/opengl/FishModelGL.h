@@ -23,6 +23,8 @@ public:
               MODELGROUP type,
               MODELNAME name,
               bool blend);
+  ~FishModelGL() override;
+
   void prepareForDraw() override;
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
 
@@ -38,6 +40,7 @@ public:
                              float scale,
                              float time,
                              int index) override;
+  FishPer *getFishPers() override;
 
   std::pair<float *, int> mViewInverseUniform;
   std::pair<float *, int> mLightWorldPosUniform;
@@ -63,6 +66,12 @@ public:
   std::pair<float, int> mScaleUniform;
   std::pair<float, int> mTimeUniform;
 
+  // Attribute locations of FishPer in the instanced path.
+  int mWorldPositionAttrib;
+  int mScaleAttrib;
+  int mNextPositionAttrib;
+  int mTimeAttrib;
+
   std::pair<TextureGL *, int> mDiffuseTexture;
   std::pair<TextureGL *, int> mNormalTexture;
   std::pair<TextureGL *, int> mReflectionTexture;
@@ -78,7 +87,24 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
+  // Layouts of the std140 uniform blocks of the shaders.
+  struct LightFactorUniforms {
+    float shininess;
+    float specularFactor;
+    float padding[2];
+  };
+  struct FishVertexUniforms {
+    float fishLength;
+    float fishWaveLength;
+    float fishBendAmount;
+    float padding;
+  };
+
+  void setUniforms();
+
   const ContextGL *mContextGL;
+  unsigned int mLightFactorBuffer;
+  unsigned int mFishVertexBuffer;
 };
 
 #endif  // FISHMODELGL_H
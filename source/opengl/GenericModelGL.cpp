@@ -12,7 +12,9 @@ GenericModelGL::GenericModelGL(const ContextGL *context,
                                MODELGROUP type,
                                MODELNAME name,
                                bool blend)
-    : Model(type, name, blend), mContextGL(context) {
+    : Model(type, name, blend),
+      mContextGL(context),
+      mLightFactorBuffer(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -32,6 +34,12 @@ GenericModelGL::GenericModelGL(const ContextGL *context,
   mFogColorUniform.first = aquarium->fogUniforms.fogColor;
 }
 
+GenericModelGL::~GenericModelGL() {
+  if (mLightFactorBuffer != 0) {
+    mContextGL->deleteUniformBuffer(mLightFactorBuffer);
+  }
+}
+
 void GenericModelGL::init() {
   ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
   mWorldViewProjectionUniform.second = mContextGL->getUniformLocation(
@@ -89,6 +97,13 @@ void GenericModelGL::init() {
       mContextGL->getAttribLocation(programGL->getProgramId(), "binormal");
 
   mIndicesBuffer = static_cast<BufferGL *>(bufferMap["indices"]);
+
+  if (mContextGL->isUniformBufferEnabled()) {
+    LightFactorUniforms lightFactorUniforms = {mShininessUniform.first,
+                                               mSpecularFactorUniform.first};
+    mLightFactorBuffer = mContextGL->createUniformBuffer(
+        &lightFactorUniforms, sizeof(lightFactorUniforms));
+  }
 }
 
 void GenericModelGL::draw() {
@@ -115,6 +130,25 @@ void GenericModelGL::prepareForDraw() {
 
   mContextGL->setIndices(*mIndicesBuffer);
 
+  if (mContextGL->isUniformBufferEnabled()) {
+    mContextGL->bindUniformBuffer(UNIFORMBINDING::LIGHTFACTORBINDING,
+                                  mLightFactorBuffer);
+    mContextGL->bindUniformBuffer(
+        UNIFORMBINDING::FOGBINDING,
+        mContextGL->getGlobalUniformBuffer(UNIFORMBINDING::FOGBINDING));
+  } else {
+    setUniforms();
+  }
+
+  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
+  // Generic models includes Arch, coral, rock, ship, etc. diffuseFragmentShader
+  // doesn't contain normalMap texture but normalMapFragmentShader contains.
+  if (mNormalTexture.second != -1) {
+    mContextGL->setTexture(*mNormalTexture.first, mNormalTexture.second, 1);
+  }
+}
+
+void GenericModelGL::setUniforms() {
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mLightWorldPosUniform.second,
@@ -137,13 +171,6 @@ void GenericModelGL::prepareForDraw() {
                          GL_FLOAT);
   mContextGL->setUniform(mFogColorUniform.second, mFogColorUniform.first,
                          GL_FLOAT_VEC4);
-
-  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
-  // Generic models includes Arch, coral, rock, ship, etc. diffuseFragmentShader
-  // doesn't contain normalMap texture but normalMapFragmentShader contains.
-  if (mNormalTexture.second != -1) {
-    mContextGL->setTexture(*mNormalTexture.first, mNormalTexture.second, 1);
-  }
 }
 
 void GenericModelGL::updatePerInstanceUniforms(
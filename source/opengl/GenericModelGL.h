@@ -19,6 +19,8 @@ public:
                  MODELGROUP type,
                  MODELNAME name,
                  bool blend);
+  ~GenericModelGL() override;
+
   void prepareForDraw() override;
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
   void init() override;
@@ -55,7 +57,17 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
+  // Layouts of the std140 uniform blocks of the shaders.
+  struct LightFactorUniforms {
+    float shininess;
+    float specularFactor;
+    float padding[2];
+  };
+
+  void setUniforms();
+
   const ContextGL *mContextGL;
+  unsigned int mLightFactorBuffer;
 };
 
 #endif  // GENERICMODELGL_H
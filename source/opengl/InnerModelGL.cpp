@@ -12,7 +12,9 @@ InnerModelGL::InnerModelGL(const ContextGL *context,
                            MODELGROUP type,
                            MODELNAME name,
                            bool blend)
-    : Model(type, name, blend), mContextGL(context) {
+    : Model(type, name, blend),
+      mContextGL(context),
+      mInnerBuffer(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -33,6 +35,12 @@ InnerModelGL::InnerModelGL(const ContextGL *context,
   mFogColorUniform.first = aquarium->fogUniforms.fogColor;
 }
 
+InnerModelGL::~InnerModelGL() {
+  if (mInnerBuffer != 0) {
+    mContextGL->deleteUniformBuffer(mInnerBuffer);
+  }
+}
+
 void InnerModelGL::init() {
   ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
   mWorldViewProjectionUniform.second = mContextGL->getUniformLocation(
@@ -94,6 +102,14 @@ void InnerModelGL::init() {
       mContextGL->getAttribLocation(programGL->getProgramId(), "binormal");
 
   mIndicesBuffer = static_cast<BufferGL *>(bufferMap["indices"]);
+
+  if (mContextGL->isUniformBufferEnabled()) {
+    InnerUniforms innerUniforms = {mEtaUniform.first,
+                                   mTankColorFudgeUniform.first,
+                                   mRefractionFudgeUniform.first};
+    mInnerBuffer =
+        mContextGL->createUniformBuffer(&innerUniforms, sizeof(innerUniforms));
+  }
 }
 
 void InnerModelGL::draw() {
@@ -116,6 +132,24 @@ void InnerModelGL::prepareForDraw() {
 
   mContextGL->setIndices(*mIndicesBuffer);
 
+  if (mContextGL->isUniformBufferEnabled()) {
+    mContextGL->bindUniformBuffer(UNIFORMBINDING::INNERBINDING,
+                                  mInnerBuffer);
+    mContextGL->bindUniformBuffer(
+        UNIFORMBINDING::FOGBINDING,
+        mContextGL->getGlobalUniformBuffer(UNIFORMBINDING::FOGBINDING));
+  } else {
+    setUniforms();
+  }
+
+  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
+  mContextGL->setTexture(*mNormalTexture.first, mNormalTexture.second, 1);
+  mContextGL->setTexture(*mReflectionTexture.first, mReflectionTexture.second,
+                         2);
+  mContextGL->setTexture(*mSkyboxTexture.first, mSkyboxTexture.second, 3);
+}
+
+void InnerModelGL::setUniforms() {
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   // lightWorldPosition is optimized away on mesa because it's not used by
@@ -134,12 +168,6 @@ void InnerModelGL::prepareForDraw() {
                          &mTankColorFudgeUniform.first, GL_FLOAT);
   mContextGL->setUniform(mRefractionFudgeUniform.second,
                          &mRefractionFudgeUniform.first, GL_FLOAT);
-
-  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
-  mContextGL->setTexture(*mNormalTexture.first, mNormalTexture.second, 1);
-  mContextGL->setTexture(*mReflectionTexture.first, mReflectionTexture.second,
-                         2);
-  mContextGL->setTexture(*mSkyboxTexture.first, mSkyboxTexture.second, 3);
 }
 
 void InnerModelGL::updatePerInstanceUniforms(
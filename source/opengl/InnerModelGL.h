@@ -19,6 +19,8 @@ public:
                MODELGROUP type,
                MODELNAME name,
                bool blend);
+  ~InnerModelGL() override;
+
   void prepareForDraw() override;
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
   void init() override;
@@ -56,7 +58,18 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
+  // Layouts of the std140 uniform blocks of the shaders.
+  struct InnerUniforms {
+    float eta;
+    float tankColorFudge;
+    float refractionFudge;
+    float padding;
+  };
+
+  void setUniforms();
+
   const ContextGL *mContextGL;
+  unsigned int mInnerBuffer;
 };
 
 #endif  // INNERMODELGL_H
@@ -7,12 +7,17 @@
 
 #include "OutsideModelGL.h"
 
+#include <cstring>
+
 OutsideModelGL::OutsideModelGL(const ContextGL *context,
                                Aquarium *aquarium,
                                MODELGROUP type,
                                MODELNAME name,
                                bool blend)
-    : Model(type, name, blend), mContextGL(context) {
+    : Model(type, name, blend),
+      mContextGL(context),
+      mLightFactorBuffer(0),
+      mFogBuffer(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -32,6 +37,15 @@ OutsideModelGL::OutsideModelGL(const ContextGL *context,
   mFogColorUniform.first = aquarium->fogUniforms.fogColor;
 }
 
+OutsideModelGL::~OutsideModelGL() {
+  if (mLightFactorBuffer != 0) {
+    mContextGL->deleteUniformBuffer(mLightFactorBuffer);
+  }
+  if (mFogBuffer != 0) {
+    mContextGL->deleteUniformBuffer(mFogBuffer);
+  }
+}
+
 void OutsideModelGL::init() {
   ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
   mWorldViewProjectionUniform.second = mContextGL->getUniformLocation(
@@ -80,6 +94,23 @@ void OutsideModelGL::init() {
       mContextGL->getAttribLocation(programGL->getProgramId(), "texCoord");
 
   mIndicesBuffer = static_cast<BufferGL *>(bufferMap["indices"]);
+
+  if (mContextGL->isUniformBufferEnabled()) {
+    LightFactorUniforms lightFactorUniforms = {mShininessUniform.first,
+                                               mSpecularFactorUniform.first};
+    mLightFactorBuffer = mContextGL->createUniformBuffer(
+        &lightFactorUniforms, sizeof(lightFactorUniforms));
+
+    // The environment box isn't fogged.
+    FogUniforms fogUniforms = {};
+    fogUniforms.fogPower = mFogPowerUniform.first;
+    fogUniforms.fogMult = mFogMultUniform.first;
+    fogUniforms.fogOffset = mFogOffsetUniform.first;
+    memcpy(fogUniforms.fogColor, mFogColorUniform.first,
+           sizeof(fogUniforms.fogColor));
+    mFogBuffer =
+        mContextGL->createUniformBuffer(&fogUniforms, sizeof(fogUniforms));
+  }
 }
 
 void OutsideModelGL::draw() {
@@ -99,6 +130,18 @@ void OutsideModelGL::prepareForDraw() {
 
   mContextGL->setIndices(*mIndicesBuffer);
 
+  if (mContextGL->isUniformBufferEnabled()) {
+    mContextGL->bindUniformBuffer(UNIFORMBINDING::LIGHTFACTORBINDING,
+                                  mLightFactorBuffer);
+    mContextGL->bindUniformBuffer(UNIFORMBINDING::FOGBINDING, mFogBuffer);
+  } else {
+    setUniforms();
+  }
+
+  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
+}
+
+void OutsideModelGL::setUniforms() {
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mLightWorldPosUniform.second,
@@ -121,8 +164,6 @@ void OutsideModelGL::prepareForDraw() {
                          GL_FLOAT);
   mContextGL->setUniform(mFogColorUniform.second, mFogColorUniform.first,
                          GL_FLOAT_VEC4);
-
-  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
 }
 
 void OutsideModelGL::updatePerInstanceUniforms(
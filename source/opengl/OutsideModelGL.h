@@ -19,6 +19,8 @@ public:
                  MODELGROUP type,
                  MODELNAME name,
                  bool blend);
+  ~OutsideModelGL() override;
+
   void prepareForDraw() override;
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
   void init() override;
@@ -51,7 +53,25 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
+  // Layouts of the std140 uniform blocks of the shaders.
+  struct LightFactorUniforms {
+    float shininess;
+    float specularFactor;
+    float padding[2];
+  };
+  struct FogUniforms {
+    float fogPower;
+    float fogMult;
+    float fogOffset;
+    float padding;
+    float fogColor[4];
+  };
+
+  void setUniforms();
+
   const ContextGL *mContextGL;
+  unsigned int mLightFactorBuffer;
+  unsigned int mFogBuffer;
 };
 
 #endif  // OUTSIDEMODELGL_H
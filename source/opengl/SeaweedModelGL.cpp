@@ -12,7 +12,9 @@ SeaweedModelGL::SeaweedModelGL(const ContextGL *context,
                                MODELGROUP type,
                                MODELNAME name,
                                bool blend)
-    : SeaweedModel(type, name, blend), mContextGL(context) {
+    : SeaweedModel(type, name, blend),
+      mContextGL(context),
+      mLightFactorBuffer(0) {
   mViewInverseUniform.first = aquarium->lightWorldPositionUniform.viewInverse;
   mLightWorldPosUniform.first =
       aquarium->lightWorldPositionUniform.lightWorldPos;
@@ -30,6 +32,12 @@ SeaweedModelGL::SeaweedModelGL(const ContextGL *context,
       aquarium->lightWorldPositionUniform.viewProjection;
 }
 
+SeaweedModelGL::~SeaweedModelGL() {
+  if (mLightFactorBuffer != 0) {
+    mContextGL->deleteUniformBuffer(mLightFactorBuffer);
+  }
+}
+
 void SeaweedModelGL::init() {
   ProgramGL *programGL = static_cast<ProgramGL *>(mProgram);
   mWorldUniform.second =
@@ -79,6 +87,13 @@ void SeaweedModelGL::init() {
       mContextGL->getAttribLocation(programGL->getProgramId(), "texCoord");
 
   mIndicesBuffer = static_cast<BufferGL *>(bufferMap["indices"]);
+
+  if (mContextGL->isUniformBufferEnabled()) {
+    LightFactorUniforms lightFactorUniforms = {mShininessUniform.first,
+                                               mSpecularFactorUniform.first};
+    mLightFactorBuffer = mContextGL->createUniformBuffer(
+        &lightFactorUniforms, sizeof(lightFactorUniforms));
+  }
 }
 
 void SeaweedModelGL::draw() {
@@ -98,6 +113,20 @@ void SeaweedModelGL::prepareForDraw() {
 
   mContextGL->setIndices(*mIndicesBuffer);
 
+  if (mContextGL->isUniformBufferEnabled()) {
+    mContextGL->bindUniformBuffer(UNIFORMBINDING::LIGHTFACTORBINDING,
+                                  mLightFactorBuffer);
+    mContextGL->bindUniformBuffer(
+        UNIFORMBINDING::FOGBINDING,
+        mContextGL->getGlobalUniformBuffer(UNIFORMBINDING::FOGBINDING));
+  } else {
+    setUniforms();
+  }
+
+  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
+}
+
+void SeaweedModelGL::setUniforms() {
   mContextGL->setUniform(mViewInverseUniform.second, mViewInverseUniform.first,
                          GL_FLOAT_MAT4);
   mContextGL->setUniform(mLightWorldPosUniform.second,
@@ -122,8 +151,6 @@ void SeaweedModelGL::prepareForDraw() {
                          GL_FLOAT_VEC4);
   mContextGL->setUniform(mViewProjectionUniform.second,
                          mViewProjectionUniform.first, GL_FLOAT_MAT4);
-
-  mContextGL->setTexture(*mDiffuseTexture.first, mDiffuseTexture.second, 0);
 }
 
 void SeaweedModelGL::updatePerInstanceUniforms(
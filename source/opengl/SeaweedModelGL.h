@@ -19,6 +19,8 @@ public:
                  MODELGROUP type,
                  MODELNAME name,
                  bool blend);
+  ~SeaweedModelGL() override;
+
   void prepareForDraw() override;
   void updatePerInstanceUniforms(const WorldUniforms &worldUniforms) override;
   void init() override;
@@ -54,7 +56,17 @@ public:
   BufferGL *mIndicesBuffer;
 
 private:
+  // Layouts of the std140 uniform blocks of the shaders.
+  struct LightFactorUniforms {
+    float shininess;
+    float specularFactor;
+    float padding[2];
+  };
+
+  void setUniforms();
+
   const ContextGL *mContextGL;
+  unsigned int mLightFactorBuffer;
 };
 
 #endif  // SEAWEEDMODELGL_H
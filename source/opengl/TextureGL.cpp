@@ -9,6 +9,8 @@
 #include "../Assert.h"
 #include "TextureGL.h"
 
+#include <algorithm>
+
 // initializs texture 2d
 TextureGL::TextureGL(ContextGL *context, std::string name, std::string url)
     : Texture(name, url, true),
@@ -30,16 +32,47 @@ TextureGL::TextureGL(ContextGL *context,
   mTextureId = context->generateTexture();
 }
 
+// Mip levels of power of 2 textures are generated on cpu, so that they can
+// be cached instead of generated by the driver on every run.
+void TextureGL::processImages() {
+  if (mTarget == GL_TEXTURE_CUBE_MAP || !isPowerOf2(mWidth) ||
+      !isPowerOf2(mHeight)) {
+    Texture::processImages();
+    return;
+  }
+
+  generateMipmap(mPixelVec[0], mWidth, mHeight, 0, mResizedVec, mWidth,
+                 mHeight, 0, 4, false);
+  std::vector<size_t> imageSizes;
+  getImageSizes(mWidth, mHeight, &imageSizes);
+  ASSERT(imageSizes.size() == mResizedVec.size());
+  for (size_t i = 0; i < mResizedVec.size(); ++i) {
+    addImage(mResizedVec[i], imageSizes[i]);
+  }
+}
+
+void TextureGL::getImageSizes(int width,
+                              int height,
+                              std::vector<size_t> *imageSizes) const {
+  if (mTarget == GL_TEXTURE_CUBE_MAP || !isPowerOf2(width) ||
+      !isPowerOf2(height)) {
+    Texture::getImageSizes(width, height, imageSizes);
+    return;
+  }
+
+  getMipImageSizes(width, height, false, imageSizes);
+}
+
 void TextureGL::loadTexture() {
+  if (!mPrepared) {
+    prepareTexture();
+  }
   mContext->bindTexture(mTarget, mTextureId);
 
-  std::vector<unsigned char *> pixelVec;
-  loadImage(mUrls, &pixelVec);
-
   if (mTarget == GL_TEXTURE_CUBE_MAP) {
     for (unsigned int i = 0; i < 6; i++) {
-      mContext->uploadTexture(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mFormat,
-                              mWidth, mHeight, pixelVec[i]);
+      mContext->uploadTexture(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mFormat, 0,
+                              mWidth, mHeight, mImageVec[i]);
     }
 
     mContext->setParameter(mTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -48,12 +81,16 @@ void TextureGL::loadTexture() {
     mContext->setParameter(mTarget, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   } else  // GL_TEXTURE_2D
   {
-    mContext->uploadTexture(mTarget, mFormat, mWidth, mHeight, pixelVec[0]);
+    for (size_t i = 0; i < mImageVec.size(); ++i) {
+      int width = std::max(mWidth >> i, 1);
+      int height = std::max(mHeight >> i, 1);
+      mContext->uploadTexture(mTarget, mFormat, static_cast<int>(i), width,
+                              height, mImageVec[i]);
+    }
 
     if (isPowerOf2(mWidth) && isPowerOf2(mHeight)) {
       mContext->setParameter(mTarget, GL_TEXTURE_MIN_FILTER,
                              GL_LINEAR_MIPMAP_LINEAR);
-      mContext->generateMipmap(mTarget);
     } else {
       mContext->setParameter(mTarget, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
       mContext->setParameter(mTarget, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -62,7 +99,7 @@ void TextureGL::loadTexture() {
     mContext->setParameter(mTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   }
 
-  DestoryImageData(pixelVec);
+  releaseImages();
 }
 
 TextureGL::~TextureGL() {
@@ -44,6 +44,11 @@ public:
   void loadTexture() override;
 
 private:
+  void processImages() override;
+  void getImageSizes(int width,
+                     int height,
+                     std::vector<size_t> *imageSizes) const override;
+
   unsigned int mTarget;
   unsigned int mTextureId;
   unsigned int mFormat;